@@ -0,0 +1,76 @@
+#ifndef CANCELTOKEN_H
+#define CANCELTOKEN_H
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// Shared cancellation flag. Copies refer to the same state. child() tokens
+// are cancelled along with their parent, so FileQueue hands every job a
+// child of its queue token. Stopping the queue cancels them all, and
+// skipping a job cancels only its own token.
+// cancel() and onCancel() belong to the GUI thread. isCancelled() can be
+// polled from anywhere.
+class CancelToken
+{
+public:
+    CancelToken() : d(std::make_shared<State>()) {}
+
+    bool isCancelled() const { return d->cancelled.load(); }
+
+    // Runs the registered callbacks synchronously, then cancels children.
+    void cancel() const
+    {
+        if (d->cancelled.exchange(true))
+            return;
+        auto callbacks = std::move(d->callbacks);
+        auto children = std::move(d->children);
+        for (auto &fn : callbacks)
+            fn();
+        for (auto &weak : children)
+            if (auto child = weak.lock())
+                CancelToken(child).cancel();
+    }
+
+    // fn runs on cancel(), or right away if that already happened.
+    void onCancel(std::function<void()> fn) const
+    {
+        if (isCancelled())
+            fn();
+        else
+            d->callbacks.push_back(std::move(fn));
+    }
+
+    CancelToken child() const
+    {
+        CancelToken c;
+        if (isCancelled()) {
+            c.d->cancelled = true;
+            return c;
+        }
+        // a queue token outlives thousands of jobs; forget the finished ones
+        auto &kids = d->children;
+        kids.erase(std::remove_if(kids.begin(), kids.end(),
+                                  [](const std::weak_ptr<State> &w) { return w.expired(); }),
+                   kids.end());
+        kids.push_back(c.d);
+        return c;
+    }
+
+private:
+    struct State {
+        std::atomic<bool> cancelled{ false };
+        std::vector<std::function<void()>> callbacks;
+        std::vector<std::weak_ptr<State>> children;
+    };
+
+    explicit CancelToken(std::shared_ptr<State> s) : d(std::move(s)) {}
+
+    std::shared_ptr<State> d;
+};
+
+#endif // CANCELTOKEN_H
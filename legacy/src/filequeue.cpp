@@ -2,29 +2,60 @@
 
 FileQueue::FileQueue() {}
 
-void FileQueue::setProcessor(std::function<void(const QString&)> processor) {
+void FileQueue::setProcessor(std::function<void(const QString&, const CancelToken&)> processor) {
     processFunc = processor;
 }
 
+void FileQueue::setConcurrency(int n) {
+    slots = qMax(1, n);
+    fill();
+}
+
 void FileQueue::enqueueFilesAndStart(const QStringList &files) {
     for (const QString &file : files)
         if (!file.isEmpty())
             queue.enqueue(file);
-    if (!processing)
-        startNext();
+    fill();
 }
 
 void FileQueue::startNext() {
-    if (queue.isEmpty()) {
-        processing = false;
-        return;
+    if (active > 0)
+        --active;
+    fill();
+}
+
+void FileQueue::requeue(const QStringList &files) {
+    for (int i = files.size() - 1; i >= 0; --i) {
+        queue.prepend(files.at(i));
+        if (active > 0)
+            --active;
+    }
+    fill();
+}
+
+void FileQueue::prioritize(const QString &file) {
+    queue.removeAll(file);
+    queue.prepend(file);
+}
+
+void FileQueue::fill() {
+    // count the slot before calling out: the processor may finish synchronously
+    while (active < slots && !queue.isEmpty() && processFunc) {
+        ++active;
+        processFunc(queue.dequeue(), queueToken.child());
     }
-    processing = true;
-    if (processFunc)
-        processFunc(queue.dequeue());
 }
 
 void FileQueue::clear() {
     queue.clear();
-    processing = false;
+    active = 0;
+}
+
+void FileQueue::cancelAll() {
+    queue.clear();
+    // new token first so anything enqueued from a cancel callback isn't born cancelled
+    const CancelToken old = queueToken;
+    queueToken = CancelToken();
+    old.cancel();
+    active = 0;
 }
@@ -6,29 +6,51 @@
 #include <QQueue>
 #include <QStringList>
 #include <functional>
+#include "canceltoken.h"
 
 class FileQueue {
 public:
     FileQueue();
 
-    // Set this to your processing lambda, e.g. [this](const QString &file){ processAudioFile(file); }
-    void setProcessor(std::function<void(const QString&)> processor);
+    // Set this to your processing lambda, e.g. [this](const QString &file, const CancelToken &token){ ... }
+    // The token is the job's own; it is also cancelled by cancelAll().
+    void setProcessor(std::function<void(const QString&, const CancelToken&)> processor);
 
-    // Enqueue files and start processing if idle
+    // How many files may be in flight at once (1 = one after another)
+    void setConcurrency(int slots);
+
+    // Enqueue files and start processing if a slot is free
     void enqueueFilesAndStart(const QStringList &files);
 
     // Called when one file is finished to trigger the next
     void startNext();
 
+    // Files handed out but never processed go back to the head of the queue;
+    // each one gives its slot back
+    void requeue(const QStringList &files);
+
+    // Move a queued file to the head of the queue, or put it there if it
+    // isn't queued (e.g. a pre-empted job going back)
+    void prioritize(const QString &file);
+    QStringList pending() const { return queue; }
+
     // Check if currently processing
-    bool isProcessing() const { return processing; }
+    bool isProcessing() const { return active > 0; }
     bool isEmpty() const { return queue.isEmpty(); }
     void clear();
 
+    // Drop everything queued and cancel every job in flight. Nothing new
+    // starts: by the time the jobs report back the queue is empty.
+    void cancelAll();
+
 private:
+    void fill();
+
     QQueue<QString> queue;
-    bool processing = false;
-    std::function<void(const QString&)> processFunc;
+    int slots = 1;
+    int active = 0;
+    CancelToken queueToken;
+    std::function<void(const QString&, const CancelToken&)> processFunc;
 };
 
 #endif // FILEQUEUE_H
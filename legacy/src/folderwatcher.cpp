@@ -0,0 +1,283 @@
+#include "folderwatcher.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QThread>
+#include <QFileSystemWatcher>
+
+#ifdef Q_OS_WIN
+#include <Windows.h>
+#include <vector>
+#endif
+
+static bool isMedia(const QString &name)
+{
+    static const QStringList exts{ "mp3", "mp4", "m4a", "mkv", "m4v", "wav", "mov", "avi",
+                                   "ogg", "flac", "aac", "wma", "opus" };
+    return exts.contains(QFileInfo(name).suffix().toLower());
+}
+
+FolderWatcher::FolderWatcher(QObject *parent) : QObject(parent)
+{
+    clock.start();
+    settleTimer.setInterval(500);
+    connect(&settleTimer, &QTimer::timeout, this, &FolderWatcher::checkPending);
+}
+
+FolderWatcher::~FolderWatcher()
+{
+    stopAll();
+}
+
+void FolderWatcher::setFolders(const QStringList &dirs)
+{
+    stopAll();
+    watched.clear();
+    pending.clear();
+    order.clear();
+
+    for (const QString &d : dirs) {
+        const QString dir = QDir(d).absolutePath();
+        if (d.isEmpty() || !QFileInfo(dir).isDir())
+            continue;
+        watched << dir;
+
+#ifdef Q_OS_WIN
+        // ReadDirectoryChangesW hands us the changed names, so a burst of
+        // thousands of files never costs a directory listing.
+        Monitor m;
+        HANDLE stopEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+        m.stopEvent = stopEvent;
+        m.thread = QThread::create([this, dir, stopEvent]{
+            HANDLE h = CreateFileW(reinterpret_cast<LPCWSTR>(QDir::toNativeSeparators(dir).utf16()),
+                                   FILE_LIST_DIRECTORY,
+                                   FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                   nullptr, OPEN_EXISTING,
+                                   FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+            if (h == INVALID_HANDLE_VALUE)
+                return;
+
+            std::vector<DWORD> buf(16 * 1024);   // 64 KB, DWORD-aligned
+            OVERLAPPED ov{};
+            ov.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+            const DWORD filter = FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE
+                               | FILE_NOTIFY_CHANGE_LAST_WRITE;
+
+            for (;;) {
+                ResetEvent(ov.hEvent);
+                if (!ReadDirectoryChangesW(h, buf.data(), DWORD(buf.size() * sizeof(DWORD)), FALSE, filter, nullptr, &ov, nullptr))
+                    break;
+
+                HANDLE waits[2] = { ov.hEvent, stopEvent };
+                DWORD bytes = 0;
+                if (WaitForMultipleObjects(2, waits, FALSE, INFINITE) != WAIT_OBJECT_0) {
+                    CancelIo(h);
+                    GetOverlappedResult(h, &ov, &bytes, TRUE);
+                    break;
+                }
+                if (!GetOverlappedResult(h, &ov, &bytes, FALSE))
+                    break;
+
+                // bytes == 0 → the kernel buffer overflowed, names were lost
+                const bool overflow = bytes == 0;
+                QStringList names;
+                for (auto *info = reinterpret_cast<FILE_NOTIFY_INFORMATION *>(buf.data()); !overflow; ) {
+                    if (info->Action == FILE_ACTION_ADDED
+                        || info->Action == FILE_ACTION_MODIFIED
+                        || info->Action == FILE_ACTION_RENAMED_NEW_NAME)
+                        names << QString::fromWCharArray(info->FileName,
+                                                         int(info->FileNameLength / sizeof(WCHAR)));
+                    if (!info->NextEntryOffset)
+                        break;
+                    info = reinterpret_cast<FILE_NOTIFY_INFORMATION *>(
+                        reinterpret_cast<char *>(info) + info->NextEntryOffset);
+                }
+
+                QMetaObject::invokeMethod(this, [this, dir, names, overflow]{
+                    overflow ? scan(dir) : noteChanged(dir, names);
+                }, Qt::QueuedConnection);
+            }
+            CloseHandle(ov.hEvent);
+            CloseHandle(h);
+        });
+        m.thread->start();
+        monitors << m;
+#endif
+    }
+
+#ifndef Q_OS_WIN
+    // QFileSystemWatcher only says "something changed", so we have to list
+    if (!watched.isEmpty()) {
+        fsWatcher = new QFileSystemWatcher(watched, this);
+        connect(fsWatcher, &QFileSystemWatcher::directoryChanged, this, &FolderWatcher::scan);
+    }
+#endif
+
+    // pick up whatever was dropped while we weren't running
+    QStringList leftovers;
+    for (const QString &dir : watched) {
+        scan(dir);
+        if (!recovered.contains(dir)) {
+            recovered.insert(dir);
+            leftovers += stranded(dir);
+        }
+    }
+    if (!leftovers.isEmpty()) {
+        for (const QString &path : leftovers)
+            inFlight.insert(path);
+        // queued: the caller may still be wiring things up
+        QMetaObject::invokeMethod(this, [this, leftovers]{ emit filesReady(leftovers); },
+                                  Qt::QueuedConnection);
+    }
+
+    if (!watched.isEmpty())
+        settleTimer.start();
+}
+
+void FolderWatcher::stopAll()
+{
+    settleTimer.stop();
+#ifdef Q_OS_WIN
+    for (Monitor &m : monitors) {
+        SetEvent(static_cast<HANDLE>(m.stopEvent));
+        m.thread->wait();
+        delete m.thread;
+        CloseHandle(static_cast<HANDLE>(m.stopEvent));
+    }
+    monitors.clear();
+#else
+    delete fsWatcher;
+    fsWatcher = nullptr;
+#endif
+}
+
+void FolderWatcher::scan(const QString &dir)
+{
+    noteChanged(dir, QDir(dir).entryList(QDir::Files));
+}
+
+void FolderWatcher::noteChanged(const QString &dir, const QStringList &names)
+{
+    for (const QString &name : names) {
+        if (!isMedia(name))
+            continue;
+        const QString path = dir + "/" + name;
+        if (pending.contains(path))
+            continue;
+        Candidate c;
+        c.stableSince = clock.elapsed();
+        pending.insert(path, c);
+        order.enqueue(path);
+    }
+}
+
+void FolderWatcher::checkPending()
+{
+    QStringList ready;
+    const qint64 now = clock.elapsed();
+
+    for (int n = qMin(checksPerTick, int(order.size())); n > 0; --n) {
+        const QString path = order.dequeue();
+        auto it = pending.find(path);
+        if (it == pending.end())
+            continue;
+
+        const QFileInfo fi(path);
+        if (!fi.exists()) {                 // producer removed it again
+            pending.erase(it);
+            continue;
+        }
+
+        const qint64 mtime = fi.lastModified().toMSecsSinceEpoch();
+        if (fi.size() != it->size || mtime != it->mtime) {
+            it->size = fi.size();
+            it->mtime = mtime;
+            it->stableSince = now;
+        } else if (now - it->stableSince >= settleMs) {
+            // rename fails while the writer still holds the file open
+            const QString claimed = claim(path);
+            if (!claimed.isEmpty()) {
+                ready << claimed;
+                pending.erase(it);
+                continue;
+            }
+        }
+        order.enqueue(path);
+    }
+
+    if (!ready.isEmpty())
+        emit filesReady(ready);
+}
+
+QString FolderWatcher::claim(const QString &path)
+{
+    const QFileInfo fi(path);
+    QDir dir(fi.absolutePath());
+    dir.mkpath("processing");
+
+    QString dest = dir.filePath("processing/" + fi.fileName());
+    for (int i = 1; QFile::exists(dest); ++i)
+        dest = dir.filePath(QString("processing/%1 (%2).%3")
+                                .arg(fi.completeBaseName()).arg(i).arg(fi.suffix()));
+
+    if (!QFile::rename(path, dest))
+        return QString();
+    inFlight.insert(dest);
+    return dest;
+}
+
+// Recordings an earlier run claimed but never finished. They are claimed
+// already, so they go straight back to the queue.
+QStringList FolderWatcher::stranded(const QString &dir) const
+{
+    const QDir processing(dir + "/processing");
+    const QStringList names = processing.entryList(QDir::Files, QDir::Name);
+
+    QSet<QString> sources;   // base names of non-mp3 recordings
+    for (const QString &name : names)
+        if (isMedia(name) && QFileInfo(name).suffix().compare("mp3", Qt::CaseInsensitive) != 0)
+            sources.insert(QFileInfo(name).completeBaseName());
+
+    QStringList out;
+    for (const QString &name : names) {
+        const QFileInfo fi(name);
+        if (!isMedia(name) || name.endsWith(".16k.wav") || inFlight.contains(processing.filePath(name)))
+            continue;
+        // the .mp3 a conversion wrote next to its source isn't a recording of its own
+        if (fi.suffix().compare("mp3", Qt::CaseInsensitive) == 0 && sources.contains(fi.completeBaseName()))
+            continue;
+        out << processing.filePath(name);
+    }
+    return out;
+}
+
+QString FolderWatcher::markDone(const QString &path, bool ok)
+{
+    inFlight.remove(path);
+
+    const QFileInfo fi(path);
+    QDir processing = fi.absoluteDir();
+    if (processing.dirName() != "processing")
+        return QString();
+
+    QDir root = processing;
+    root.cdUp();
+    if (!watched.contains(root.absolutePath()))
+        return QString();
+
+    const QString target = ok ? "processed/" : "failed/";
+    root.mkpath(target);
+
+    // source plus the .mp3 / .mp3.txt / .mp3.srt written next to it
+    const QString mp3 = fi.completeBaseName() + ".mp3";
+    const QStringList outputs{ fi.fileName(), mp3, mp3 + ".txt", mp3 + ".srt" };
+    for (const QString &name : outputs) {
+        if (!processing.exists(name))
+            continue;
+        const QString dest = root.filePath(target + name);
+        QFile::remove(dest);
+        QFile::rename(processing.filePath(name), dest);
+    }
+    return root.filePath(target + fi.fileName());
+}
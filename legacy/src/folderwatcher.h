@@ -0,0 +1,76 @@
+#ifndef FOLDERWATCHER_H
+#define FOLDERWATCHER_H
+
+#pragma once
+
+#include <QObject>
+#include <QHash>
+#include <QQueue>
+#include <QSet>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QStringList>
+
+class QThread;
+class QFileSystemWatcher;
+
+// Watches drop folders for new recordings. Each file is claimed into
+// <folder>/processing/ once its size and mtime have stopped changing.
+// markDone() then moves it and its outputs to <folder>/processed/, or to
+// <folder>/failed/ if the job failed. Files a previous run left in
+// processing/ (crash, Stop, Skip) are queued again when the folder is
+// first watched.
+class FolderWatcher : public QObject
+{
+    Q_OBJECT
+public:
+    explicit FolderWatcher(QObject *parent = nullptr);
+    ~FolderWatcher();
+
+    void setFolders(const QStringList &dirs);
+    QStringList folders() const { return watched; }
+
+    // Call when the pipeline is finished with a file returned by filesReady().
+    // Returns where the source ended up, or "" if it isn't a hot-folder file.
+    QString markDone(const QString &path, bool ok = true);
+
+    int settleMs = 2000;      // unchanged this long → writer is done
+    int checksPerTick = 200;  // stat() budget per tick, keeps the GUI thread responsive on slow shares
+
+signals:
+    void filesReady(const QStringList &paths);
+
+private:
+    struct Candidate {
+        qint64 size = -1;
+        qint64 mtime = -1;
+        qint64 stableSince = 0;
+    };
+
+    void noteChanged(const QString &dir, const QStringList &names);
+    void scan(const QString &dir);   // startup / overflow only
+    void checkPending();
+    QString claim(const QString &path);
+    QStringList stranded(const QString &dir) const;
+    void stopAll();
+
+    QStringList watched;
+    QHash<QString, Candidate> pending;
+    QQueue<QString> order;           // round-robin over pending
+    QTimer settleTimer;
+    QElapsedTimer clock;
+    QSet<QString> inFlight;          // claimed this session, not yet marked done
+    QSet<QString> recovered;         // folders whose processing/ was already swept
+
+#ifdef Q_OS_WIN
+    struct Monitor {
+        QThread *thread = nullptr;
+        void *stopEvent = nullptr;   // HANDLE
+    };
+    QList<Monitor> monitors;
+#else
+    QFileSystemWatcher *fsWatcher = nullptr;
+#endif
+};
+
+#endif // FOLDERWATCHER_H
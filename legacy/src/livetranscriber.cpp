@@ -12,12 +12,32 @@ LiveTranscriber::LiveTranscriber(QObject *parent) : QObject(parent)
         static const QRegularExpression escSeq(R"(\x1B\[[0-9;]*[A-Za-z])"); // ANSI
         QString txt = QString::fromLocal8Bit(proc.readAll());
         txt.remove(escSeq);                     // ⚑ deletes “\x1B[2K”, colors, etc.
+
+        // whisper-stream drops audio when inference can't keep up with --step
+        const bool dropped = txt.contains("cannot process audio fast enough");
+        if (dropped)
+            txt.clear();
+
+        if (!listening && txt.contains("[Start speaking]")) {
+            listening = true;
+            sinceWindow.start();
+        } else if (listening) {
+            onWindow(dropped);
+        }
+
         emit newText(txt.trimmed());
     });
 
     connect(&proc,
             QOverload<int,QProcess::ExitStatus>::of(&QProcess::finished),
-            this, &LiveTranscriber::finished);
+            this, [this]{
+                if (restarting) {   // our own restart, not the user's stop
+                    restarting = false;
+                    launch();
+                    return;
+                }
+                emit finished();
+            });
 }
 
 void LiveTranscriber::start(const QString &model, const QString &lang,
@@ -25,16 +45,35 @@ void LiveTranscriber::start(const QString &model, const QString &lang,
 {
     if (proc.state() != QProcess::NotRunning) return;
 
+    this->model  = model;
+    language     = lang;
+    noGpu        = cpuOnly;
+    baseStep     = step   = stepMs;
+    baseLength   = length = lengthMs;
+    failedStep   = 0;
+    probeWindows = 60;
+    probing      = false;
+    restarting   = false;
+
+    launch();
+}
+
+void LiveTranscriber::launch()
+{
     QString exe = QCoreApplication::applicationDirPath() + "/whisper-stream.exe";
 
     QStringList args{
         "-m", model,
-        "-l", lang,
-        "--step", QString::number(stepMs),
-        "--length", QString::number(lengthMs),
+        "-l", language,
+        "--step", QString::number(step),
+        "--length", QString::number(length),
         "-t", QString::number(QThread::idealThreadCount())
     };
-    if (cpuOnly) args << "--no-gpu";
+    if (noGpu) args << "--no-gpu";
+
+    listening = false;
+    windows = behindRun = aheadRun = 0;
+    avgMs = 0.0;
 
     proc.setProgram(exe);
     proc.setArguments(args);
@@ -43,8 +82,80 @@ void LiveTranscriber::start(const QString &model, const QString &lang,
 
 void LiveTranscriber::stop()
 {
+    restarting = false;
     if (proc.state() == QProcess::NotRunning) return;
+    // bounded: a console process on Windows ignores terminate()
     proc.terminate();
-    if (!proc.waitForFinished(1500))
+    if (!proc.waitForFinished(200)) {
         proc.kill();
+        proc.waitForFinished(300);
+    }
+}
+
+/* ---------- adaptive step / window ---------- */
+// The time between windows is max(step, inference). If it stays above the
+// step we are behind: widen the step (AIMD), then fall back to a smaller
+// model once the step would pass the target latency. Every change restarts
+// whisper-stream (model reload, lost mic audio), so probing back down is
+// slow: only after a long run of windows that kept up, never below the
+// requested step or to one that already fell behind, and each failed probe
+// doubles the wait before the next.
+void LiveTranscriber::onWindow(bool dropped)
+{
+    // several reads per window arrive back to back
+    if (!dropped && sinceWindow.elapsed() < 50)
+        return;
+
+    const qint64 interval = sinceWindow.restart();
+    if (++windows <= 2)     // first windows after a (re)load are irregular
+        return;
+
+    avgMs = avgMs == 0.0 ? interval : 0.8 * avgMs + 0.2 * interval;
+
+    const int newLag = qMax(0, int(avgMs) - step);
+    if (newLag != lag) {
+        lag = newLag;
+        emit lagChanged(lag, step, length);
+    }
+
+    const bool behind = dropped || avgMs > step * 1.15;
+    behindRun = behind ? behindRun + 1 : 0;
+    aheadRun  = behind ? 0 : aheadRun + 1;
+
+    if (behindRun >= 3) {
+        if (probing)
+            probeWindows = qMin(probeWindows * 2, 960);
+        probing = false;
+        failedStep = qMax(failedStep, step);
+        int wider = int(qMax(step * 1.5, avgMs * 1.2));
+        wider = (wider + 99) / 100 * 100;
+
+        if (wider > targetMs && !fallbacks.isEmpty()) {
+            model = fallbacks.takeFirst();
+            failedStep = 0;
+            emit modelChanged(model);
+            restartWith(baseStep);
+        } else if (qMin(wider, targetMs) != step) {
+            restartWith(qMin(wider, targetMs));
+        }
+    } else if (aheadRun >= probeWindows) {
+        probing = false;   // the last probe held
+        const int narrower = qMax(baseStep, int(step * 0.8) / 50 * 50);
+        if (narrower < step && narrower > failedStep) {
+            probing = true;
+            restartWith(narrower);
+        }
+        aheadRun = 0;
+    }
+}
+
+void LiveTranscriber::restartWith(int newStep)
+{
+    step   = newStep;
+    length = qMax(baseLength, 2 * step);
+    emit lagChanged(lag, step, length);
+
+    // whisper-stream only takes these on the command line
+    restarting = true;
+    proc.kill();
 }
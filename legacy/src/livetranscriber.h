@@ -4,6 +4,8 @@
 #pragma once
 #include <QObject>
 #include <QProcess>
+#include <QElapsedTimer>
+#include <QStringList>
 
 class LiveTranscriber : public QObject
 {
@@ -18,12 +20,51 @@ public:
                int lengthMs = 5000);
     void stop();
 
+    // Step is never widened past this; beyond it we switch to a fallback model.
+    void setTargetLatency(int ms) { targetMs = ms; }
+    // Smaller models to fall back to, next-smaller first.
+    void setFallbackModels(const QStringList &paths) { fallbacks = paths; }
+
+    int lagMs() const    { return lag; }
+    int stepMs() const   { return step; }
+    int lengthMs() const { return length; }
+
 signals:
     void newText(const QString &line);   // each chunk from stdout
     void finished();                     // process exited
+    void lagChanged(int lagMs, int stepMs, int lengthMs);
+    void modelChanged(const QString &modelPath);
 
 private:
+    void launch();
+    void onWindow(bool dropped);
+    void restartWith(int newStep);
+
     QProcess proc;
+
+    /* launch parameters */
+    QString model;
+    QString language;
+    bool noGpu = false;
+    int baseStep = 500;
+    int baseLength = 5000;
+    int step = 500;
+    int length = 5000;
+    QStringList fallbacks;
+
+    /* controller state */
+    int targetMs = 2000;
+    int failedStep = 0;     // largest step seen falling behind; probes stay above it
+    int probeWindows = 60;  // windows kept up before probing a smaller step
+    bool probing = false;   // the current step is a probe that hasn't held yet
+    bool listening = false; // past model load, windows are arriving
+    bool restarting = false;
+    int windows = 0;
+    int behindRun = 0;
+    int aheadRun = 0;
+    double avgMs = 0.0;     // EWMA of time between windows
+    int lag = 0;
+    QElapsedTimer sinceWindow;
 };
 
 #endif // LIVETRANSCRIBER_H
@@ -1,11 +1,67 @@
 #include "mainwindow.h"
 #include <QApplication>
 #include <QString>
+#include <QTextStream>
+#include "transcriptindex.h"
+#include "workerserver.h"
+#include "workerprotocol.h"
+
+#ifdef Q_OS_WIN
+#include <Windows.h>
+#include <cstdio>
+#endif
+
+// GUI subsystem: borrow the caller's console unless stdout is redirected
+static void attachConsole()
+{
+#ifdef Q_OS_WIN
+    if (GetFileType(GetStdHandle(STD_OUTPUT_HANDLE)) == FILE_TYPE_UNKNOWN
+        && AttachConsole(ATTACH_PARENT_PROCESS))
+        freopen("CONOUT$", "w", stdout);
+#endif
+}
 
 int main(int argc, char *argv[])
 {
     QApplication a(argc, argv);
 
+    // headless: EasyWhisperUI --search "phrase"  → file<TAB>start<TAB>end<TAB>text
+    if (argc > 2 && QString(argv[1]) == "--search") {
+        attachConsole();
+        QTextStream out(stdout);
+        TranscriptIndex index;
+        for (const auto &h : index.search(QString::fromLocal8Bit(argv[2])))
+            out << h.file << '\t' << TranscriptIndex::formatTime(h.startMs) << '\t'
+                << TranscriptIndex::formatTime(h.endMs) << '\t' << h.text << '\n';
+        return 0;
+    }
+
+    // headless: EasyWhisperUI --worker [port] [--bind address]  → serve jobs to a coordinator
+    // localhost only unless --bind says otherwise (e.g. --bind 0.0.0.0)
+    if (argc > 1 && QString(argv[1]) == "--worker") {
+        attachConsole();
+        quint16 port = WorkerProtocol::defaultPort;
+        QHostAddress address = QHostAddress::LocalHost;
+        for (int i = 2; i < argc; ++i) {
+            const QString arg = argv[i];
+            if (arg == "--bind" && i + 1 < argc)
+                address = QHostAddress(QString(argv[++i]));
+            else
+                port = quint16(arg.toUInt());
+        }
+        WorkerServer worker;
+        QObject::connect(&worker, &WorkerServer::log, [](const QString &line){
+            QTextStream(stdout) << line << Qt::endl;
+        });
+        if (address.isNull()) {
+            QTextStream(stdout) << "Invalid --bind address" << Qt::endl;
+            return 1;
+        }
+        if (!worker.listen(port, address))
+            return 1;
+        return a.exec();
+    }
+
     MainWindow w;
     w.setWindowTitle("Whisper UI");
     w.setWindowIcon(QIcon(":resources/icon.png"));
@@ -16,6 +72,14 @@ int main(int argc, char *argv[])
         QStringList fileArgs;
         for (int i = 1; i < argc; ++i) {
             QString arg = argv[i];
+            if (arg == "--watch" && i + 1 < argc) {
+                w.addWatchFolder(QString::fromLocal8Bit(argv[++i]));
+                continue;
+            }
+            if (arg == "--workers" && i + 1 < argc) {
+                w.setWorkers(QString::fromLocal8Bit(argv[++i]).split(','));
+                continue;
+            }
             if (!arg.isEmpty())
                 fileArgs << arg;
         }
@@ -3,8 +3,17 @@
 #include "settings.h"
 #include "transcriptionpipeline.h"
 #include "livetranscriber.h"
+#include "modelprofile.h"
 #include <QFileDialog>
 #include <QProcess>
+#include <QFileInfo>
+#include <QDir>
+#include <QFile>
+#include <QStatusBar>
+#include <QMenuBar>
+#include <QInputDialog>
+#include <QLineEdit>
+#include <QElapsedTimer>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
@@ -13,7 +22,7 @@ MainWindow::MainWindow(QWidget *parent)
     ui->setupUi(this);
     ui->console->setReadOnly(true);
 
-    appSettings.load(ui->model, ui->language, ui->txtCheckbox, ui->srtCheckbox, ui->cpuCheckbox, ui->openCheckbox, ui->arguments);
+    appSettings.load(ui->model, ui->language, ui->precision, ui->txtCheckbox, ui->srtCheckbox, ui->cpuCheckbox, ui->openCheckbox, ui->draftCheckbox, ui->arguments);
 
     connect(ui->openFile, &QPushButton::clicked,
             this, &MainWindow::onOpenFileClicked);
@@ -24,47 +33,74 @@ MainWindow::MainWindow(QWidget *parent)
 
     connect(ui->txtCheckbox, &QCheckBox::toggled, this, [=](bool checked){
         txtFlag = ui->txtCheckbox->isChecked() ? "-otxt" : "";
-        appSettings.save(ui->model, ui->language, ui->txtCheckbox, ui->srtCheckbox, ui->cpuCheckbox, ui->openCheckbox, ui->arguments);
+        appSettings.save(ui->model, ui->language, ui->precision, ui->txtCheckbox, ui->srtCheckbox, ui->cpuCheckbox, ui->openCheckbox, ui->draftCheckbox, ui->arguments);
     });
     connect(ui->srtCheckbox, &QCheckBox::toggled, this, [=](bool checked){
         srtFlag = ui->srtCheckbox->isChecked() ? "-osrt" : "";
-        appSettings.save(ui->model, ui->language, ui->txtCheckbox, ui->srtCheckbox, ui->cpuCheckbox, ui->openCheckbox, ui->arguments);
+        appSettings.save(ui->model, ui->language, ui->precision, ui->txtCheckbox, ui->srtCheckbox, ui->cpuCheckbox, ui->openCheckbox, ui->draftCheckbox, ui->arguments);
     });
     connect(ui->cpuCheckbox, &QCheckBox::toggled, this, [=](bool checked){
         cpuFlag = ui->cpuCheckbox->isChecked() ? "--no-gpu" : "";
-        appSettings.save(ui->model, ui->language, ui->txtCheckbox, ui->srtCheckbox, ui->cpuCheckbox, ui->openCheckbox, ui->arguments);
+        appSettings.save(ui->model, ui->language, ui->precision, ui->txtCheckbox, ui->srtCheckbox, ui->cpuCheckbox, ui->openCheckbox, ui->draftCheckbox, ui->arguments);
     });
     connect(ui->openCheckbox, &QCheckBox::toggled, this, [=](bool checked){
-        appSettings.save(ui->model, ui->language, ui->txtCheckbox, ui->srtCheckbox, ui->cpuCheckbox, ui->openCheckbox, ui->arguments);
+        appSettings.save(ui->model, ui->language, ui->precision, ui->txtCheckbox, ui->srtCheckbox, ui->cpuCheckbox, ui->openCheckbox, ui->draftCheckbox, ui->arguments);
+    });
+    connect(ui->draftCheckbox, &QCheckBox::toggled, this, [=](bool checked){
+        appSettings.save(ui->model, ui->language, ui->precision, ui->txtCheckbox, ui->srtCheckbox, ui->cpuCheckbox, ui->openCheckbox, ui->draftCheckbox, ui->arguments);
     });
 
     connect(ui->model, &QComboBox::currentTextChanged, this, [this](const QString& txt){
-        appSettings.save(ui->model, ui->language, ui->txtCheckbox, ui->srtCheckbox, ui->cpuCheckbox, ui->openCheckbox, ui->arguments);
+        appSettings.save(ui->model, ui->language, ui->precision, ui->txtCheckbox, ui->srtCheckbox, ui->cpuCheckbox, ui->openCheckbox, ui->draftCheckbox, ui->arguments);
+        prefetchModel();
     });
     connect(ui->language, &QComboBox::currentTextChanged, this, [this](const QString& txt){
-        appSettings.save(ui->model, ui->language, ui->txtCheckbox, ui->srtCheckbox, ui->cpuCheckbox, ui->openCheckbox, ui->arguments);
+        appSettings.save(ui->model, ui->language, ui->precision, ui->txtCheckbox, ui->srtCheckbox, ui->cpuCheckbox, ui->openCheckbox, ui->draftCheckbox, ui->arguments);
+    });
+    connect(ui->precision, &QComboBox::currentTextChanged, this, [this](const QString& txt){
+        appSettings.save(ui->model, ui->language, ui->precision, ui->txtCheckbox, ui->srtCheckbox, ui->cpuCheckbox, ui->openCheckbox, ui->draftCheckbox, ui->arguments);
+        prefetchModel();
     });
 
     connect(ui->arguments, &QPlainTextEdit::textChanged, this, [this]{
-        appSettings.save(ui->model, ui->language, ui->txtCheckbox, ui->srtCheckbox, ui->cpuCheckbox, ui->openCheckbox, ui->arguments);
+        appSettings.save(ui->model, ui->language, ui->precision, ui->txtCheckbox, ui->srtCheckbox, ui->cpuCheckbox, ui->openCheckbox, ui->draftCheckbox, ui->arguments);
     });
 
 
     windowHelper = new WindowHelper(this, ui, this);
     windowHelper->handleBlur();
 
-    fileQueue.setProcessor([this](const QString &file){
-        transcribe->start(file);
+    fileQueue.setProcessor([this](const QString &file, const CancelToken &token){
+        if (localBusy) {
+            // UNC paths are reachable from the workers, everything else is sent along
+            workerPool->submit(file, {
+                { "model", ui->model->currentText() },
+                { "language", ui->language->currentText() },
+                { "precision", ui->precision->currentIndex() },
+                { "args", ui->arguments->toPlainText() },
+                { "cpu", ui->cpuCheckbox->isChecked() },
+                { "txt", ui->txtCheckbox->isChecked() },
+                { "srt", ui->srtCheckbox->isChecked() },
+                { "shared", QDir::fromNativeSeparators(file).startsWith("//") }
+            }, token);
+            return;
+        }
+        localBusy = true;
+        localToken = token;
+        m_filePath = file;
+        transcribe->start(file, token);
     });
 
     transcribe = new TranscriptionPipeline(
         ui->console,
         ui->model,
         ui->language,
+        ui->precision,
         ui->txtCheckbox,
         ui->srtCheckbox,
         ui->cpuCheckbox,
         ui->openCheckbox,
+        ui->draftCheckbox,
         ui->arguments,
         &processList,
         this
@@ -72,7 +108,122 @@ MainWindow::MainWindow(QWidget *parent)
 
     // when one file is done, dequeue and run the next
     connect(transcribe, &TranscriptionPipeline::finished,
-            this, [this]() { fileQueue.startNext(); });
+            this, [this]() {
+                localBusy = false;
+                if (localToken.isCancelled()) {
+                    // a hot-folder file stays in processing/ rather than being marked done
+                    doneSource.clear();
+                    doneOutput.clear();
+                    fileQueue.startNext();
+                    return;
+                }
+                // transcribed() only fires on success
+                const bool ok = !doneSource.isEmpty();
+                finishJob(ok ? doneSource : m_filePath, doneOutput, ok);
+                doneSource.clear();
+                doneOutput.clear();
+            });
+    connect(transcribe, &TranscriptionPipeline::transcribed,
+            this, [this](const QString &source, const QString &output) {
+                doneSource = source;
+                doneOutput = output;
+            });
+
+    // hot folders: stable files are claimed and queued like a drop
+    folderWatcher = new FolderWatcher(this);
+    connect(folderWatcher, &FolderWatcher::filesReady,
+            this, [this](const QStringList &files) { fileQueue.enqueueFilesAndStart(files); });
+    folderWatcher->setFolders(appSettings.watchFolders());
+
+    QAction *watchAction = menuBar()->addAction("Watch Folder…");
+    connect(watchAction, &QAction::triggered, this, [this]{
+        const QString dir = QFileDialog::getExistingDirectory(this, tr("Watch Folder"));
+        if (!dir.isEmpty())
+            addWatchFolder(dir);
+    });
+    QAction *searchAction = menuBar()->addAction("Search Transcripts…");
+    connect(searchAction, &QAction::triggered, this, &MainWindow::searchTranscripts);
+    // distributed mode: every connected worker adds a FileQueue slot
+    workerPool = new WorkerPool(this);
+    connect(workerPool, &WorkerPool::capacityChanged,
+            this, [this](int workers) { fileQueue.setConcurrency(1 + workers); });
+    connect(workerPool, &WorkerPool::message,
+            ui->console, &QPlainTextEdit::appendPlainText);
+    connect(workerPool, &WorkerPool::jobFinished,
+            this, [this](const QString &file, bool ok, const QString &output) {
+                finishJob(file, ok ? output : QString(), ok);
+            });
+    connect(workerPool, &WorkerPool::jobsReturned,
+            this, [this](const QStringList &files) { fileQueue.requeue(files); });
+    connect(workerPool, &WorkerPool::jobCancelled,
+            this, [this](const QString &) { fileQueue.startNext(); });
+    workerPool->setWorkers(appSettings.workers());
+
+    QAction *workersAction = menuBar()->addAction("Workers…");
+    connect(workersAction, &QAction::triggered, this, [this]{
+        bool ok = false;
+        const QString list = QInputDialog::getText(this, tr("Workers"),
+                                                   tr("host:port, comma separated (empty = local only):"),
+                                                   QLineEdit::Normal,
+                                                   workerPool->workers().join(", "), &ok);
+        if (ok)
+            setWorkers(list.split(',', Qt::SkipEmptyParts));
+    });
+
+    QAction *skipAction = menuBar()->addAction("Skip Current");
+    connect(skipAction, &QAction::triggered, this, [this]{
+        if (localBusy)
+            localToken.cancel();   // the queue carries on with the next file
+    });
+
+    // reordering is a list move, pre-empting costs one bounded cancel
+    QAction *runNextAction = menuBar()->addAction("Run Next…");
+    connect(runNextAction, &QAction::triggered, this, [this]{
+        const QString file = pickQueued(tr("Run Next"));
+        if (!file.isEmpty())
+            fileQueue.prioritize(file);
+    });
+    QAction *runNowAction = menuBar()->addAction("Run Now…");
+    connect(runNowAction, &QAction::triggered, this, [this]{
+        const QString file = pickQueued(tr("Run Now"));
+        if (file.isEmpty())
+            return;
+        if (localBusy)
+            fileQueue.prioritize(m_filePath);   // the pre-empted job runs right after
+        fileQueue.prioritize(file);
+        if (localBusy)
+            localToken.cancel();                // its finished handler starts `file`
+    });
+
+    QAction *unwatchAction = menuBar()->addAction("Stop Watching");
+    connect(unwatchAction, &QAction::triggered, this, [this]{
+        folderWatcher->setFolders({});
+        appSettings.setWatchFolders({});
+        ui->console->appendPlainText("Stopped watching folders.");
+    });
+
+    // warm the model the next job will load, starting with the saved one
+    prefetcher = new ModelPrefetcher(this);
+    connect(prefetcher, &ModelPrefetcher::done,
+            this, [this](const QString &path, ModelPrefetcher::Result result, qint64 bytes, qint64 ms){
+                const QString name = QFileInfo(path).fileName();
+                if (result == ModelPrefetcher::Ready) {
+                    statusBar()->showMessage(QString("Model ready: %1 (%2 MB in %3 ms)")
+                                                 .arg(name).arg(bytes / (1024 * 1024)).arg(ms), 5000);
+                } else if (result == ModelPrefetcher::Unreadable) {
+                    ui->console->appendPlainText("Warning: " + name + " is unreadable.");
+                } else {
+                    // out of the way, so the next job downloads (or rebuilds) it
+                    QFile::remove(path + ".bad");
+                    if (QFile::rename(path, path + ".bad"))
+                        ui->console->appendPlainText("Warning: " + name + " is damaged; moved it to "
+                                                     + name + ".bad. The next job fetches it again.");
+                    else
+                        ui->console->appendPlainText("Warning: " + name + " is damaged and in use; "
+                                                     "delete it so it can be fetched again.");
+                }
+            });
+    prefetchModel();
 
     setAcceptDrops(true);
 
@@ -82,6 +233,14 @@ MainWindow::MainWindow(QWidget *parent)
     ui->live->setIconSize(QSize(20, 20));
     ui->live->setToolTip("Start live transcription (Ctrl+M)");
 
+    connect(live.get(), &LiveTranscriber::lagChanged, this, [this](int lagMs, int stepMs, int lengthMs){
+        statusBar()->showMessage(QString("Live lag: %1 ms  (step %2 ms, window %3 ms)")
+                                     .arg(lagMs).arg(stepMs).arg(lengthMs));
+    });
+    connect(live.get(), &LiveTranscriber::modelChanged, this, [this](const QString &path){
+        ui->console->appendPlainText("Live: falling behind, switched to " + QFileInfo(path).fileName());
+    });
+
 }
 
 MainWindow::~MainWindow()
@@ -99,22 +258,108 @@ void MainWindow::onOpenFileClicked()
         );
 
     fileQueue.enqueueFilesAndStart(filePaths);
-    appSettings.save(ui->model, ui->language, ui->txtCheckbox, ui->srtCheckbox, ui->cpuCheckbox, ui->openCheckbox, ui->arguments);
+    appSettings.save(ui->model, ui->language, ui->precision, ui->txtCheckbox, ui->srtCheckbox, ui->cpuCheckbox, ui->openCheckbox, ui->draftCheckbox, ui->arguments);
+}
+
+void MainWindow::addWatchFolder(const QString &dir)
+{
+    QStringList dirs = folderWatcher->folders();
+    const QString abs = QDir(dir).absolutePath();
+    if (!dirs.contains(abs))
+        dirs << abs;
+    folderWatcher->setFolders(dirs);
+    appSettings.setWatchFolders(folderWatcher->folders());
+    ui->console->appendPlainText("Watching: " + folderWatcher->folders().join(", "));
+}
+
+void MainWindow::finishJob(const QString &source, const QString &whisperOutput, bool ok)
+{
+    const QString moved = folderWatcher->markDone(source, ok);
+    if (!whisperOutput.isEmpty())
+        transcriptIndex.add(moved.isEmpty() ? source : moved,
+                            TranscriptIndex::parseSegments(whisperOutput));
+    fileQueue.startNext();
+}
+
+QString MainWindow::pickQueued(const QString &title)
+{
+    const QStringList files = fileQueue.pending();
+    if (files.isEmpty()) {
+        statusBar()->showMessage("Nothing queued.", 3000);
+        return QString();
+    }
+    bool ok = false;
+    const QString file = QInputDialog::getItem(this, title, tr("Queued file:"), files, 0, false, &ok);
+    return ok ? file : QString();
+}
+
+void MainWindow::setWorkers(const QStringList &hostPorts)
+{
+    QStringList cleaned;
+    for (const QString &hp : hostPorts)
+        if (!hp.trimmed().isEmpty())
+            cleaned << hp.trimmed();
+    workerPool->setWorkers(cleaned);
+    appSettings.setWorkers(cleaned);
+    ui->console->appendPlainText(cleaned.isEmpty() ? "Workers: local only"
+                                                   : "Workers: " + cleaned.join(", "));
+}
+
+void MainWindow::searchTranscripts()
+{
+    const QString phrase = QInputDialog::getText(this, tr("Search Transcripts"), tr("Phrase:"));
+    if (phrase.trimmed().isEmpty())
+        return;
+
+    QElapsedTimer t;
+    t.start();
+    const auto hits = transcriptIndex.search(phrase);
+
+    ui->console->appendPlainText(QString("Search \"%1\": %2 hit(s) in %3 ms")
+                                     .arg(phrase).arg(hits.size()).arg(t.elapsed()));
+    for (const auto &h : hits)
+        ui->console->appendPlainText(h.file + " @ " + TranscriptIndex::formatTime(h.startMs)
+                                     + "  " + h.text);
+}
+
+void MainWindow::prefetchModel()
+{
+    const QString name = ui->model->currentText();
+    const QString quant = ModelProfile::choose(name,
+                                               ModelProfile::Preference(ui->precision->currentIndex()),
+                                               ui->cpuCheckbox->isChecked());
+    QString path = ModelProfile::fileFor(name, quant);
+    if (!QFile::exists(path))
+        path = ModelProfile::fileFor(name);   // variant gets built from this one
+
+    if (QFile::exists(path))
+        prefetcher->prefetch(path);
+    else
+        prefetcher->cancel();                 // first job downloads it anyway
 }
 
 void MainWindow::clearConsole()
 {
+    transcribe->clearDrafts();
     ui->console->clear();
 }
 
 void MainWindow::exitProcesses()
 {
+    QElapsedTimer t;
+    t.start();
+
+    // every queued and running job, local and remote; the local pipeline has
+    // reaped its processes and removed its partial files when this returns
+    fileQueue.cancelAll();
+    prefetcher->cancel();
+
     for (int i = processList.size() - 1; i >= 0; --i) {
         QProcess* proc = processList[i];
         proc->kill();                // Safe even if already finished
         processList.removeAt(i);
     }
-    ui->console->appendPlainText("The user stopped the process.");
+    ui->console->appendPlainText(QString("The user stopped the process (%1 ms).").arg(t.elapsed()));
 }
 
 void MainWindow::changeEvent(QEvent *event) {
@@ -129,10 +374,7 @@ void MainWindow::dragEnterEvent(QDragEnterEvent *event)
 
 void MainWindow::dropEvent(QDropEvent *event) {
     QStringList files = windowHelper->handleDrop(event);
-    for (const QString &filePath : files)
-        fileQueue.enqueueFilesAndStart(QStringList() << filePath);
-    if (!isProcessing)
-        fileQueue.startNext();
+    fileQueue.enqueueFilesAndStart(files);
 }
 
 void MainWindow::on_live_toggled(bool recording)
@@ -144,6 +386,7 @@ void MainWindow::on_live_toggled(bool recording)
         QString modelPath = QCoreApplication::applicationDirPath()
         + "/models/ggml-" + ui->model->currentText() + ".bin";
 
+        live->setFallbackModels(ModelProfile::smallerModels(ui->model->currentText()));
         live->start(modelPath,
                     ui->language->currentText(),
                     ui->cpuCheckbox->isChecked());
@@ -183,6 +426,7 @@ void MainWindow::on_live_toggled(bool recording)
     } else {
         live->stop();
         ui->openFile->setEnabled(true);
+        statusBar()->clearMessage();
     }
 }
 
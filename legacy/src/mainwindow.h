@@ -7,6 +7,10 @@
 #include "windowhelper.h"
 #include "transcriptionpipeline.h"
 #include "livetranscriber.h"
+#include "folderwatcher.h"
+#include "transcriptindex.h"
+#include "modelprefetcher.h"
+#include "workerpool.h"
 
 QT_BEGIN_NAMESPACE
 namespace Ui {
@@ -22,6 +26,8 @@ public:
     MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
     void processAudioFile(const QString &filePath);
+    void addWatchFolder(const QString &dir);
+    void setWorkers(const QStringList &hostPorts);
     FileQueue fileQueue;
 
 private slots:
@@ -32,7 +38,12 @@ private slots:
     void exitProcesses();
     void clearConsole();
     void on_live_toggled(bool recording);
+    void searchTranscripts();
+    void prefetchModel();
+    void finishJob(const QString &source, const QString &whisperOutput, bool ok);
 private:
+    QString pickQueued(const QString &title);
+
     WindowHelper *windowHelper;
     Ui::EasyWhisperUI *ui;
     Settings appSettings;
@@ -40,8 +51,15 @@ private:
     QString txtFlag;
     QString srtFlag;
     QString cpuFlag;
-    bool isProcessing = false;
     TranscriptionPipeline *transcribe;
+    FolderWatcher *folderWatcher;
+    TranscriptIndex transcriptIndex;
+    ModelPrefetcher *prefetcher;
+    WorkerPool *workerPool;
+    bool localBusy = false;   // the local pipeline holds one FileQueue slot, workers the rest
+    CancelToken localToken;   // the local job's token, for "Skip Current"
+    QString doneSource;       // last job's source + whisper output, indexed on finish
+    QString doneOutput;
     std::unique_ptr<LiveTranscriber> live = std::make_unique<LiveTranscriber>(this);
     QList<QProcess*> processList;
 };
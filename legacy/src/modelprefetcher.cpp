@@ -0,0 +1,169 @@
+#include "modelprefetcher.h"
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QPointer>
+#include <QThread>
+#include <QtEndian>
+
+#ifndef Q_OS_WIN
+#include <fcntl.h>
+#endif
+
+static constexpr qint64 kChunk = 4 * 1024 * 1024;
+static constexpr quint32 kGgmlMagic = 0x67676d6c;   // "ggml", little-endian on disk
+static constexpr int kHparams = 11;                 // n_vocab .. ftype
+
+// Bytes of tensor data for `elements` values of ggml type `type`, or -1 if
+// the type is unknown or the count doesn't fill whole blocks.
+static qint64 tensorBytes(qint32 type, qint64 elements)
+{
+    static const struct { qint32 type; int blockBytes; int blockSize; } kTypes[] = {
+        {  0,   4,   1 },   // F32
+        {  1,   2,   1 },   // F16
+        {  2,  18,  32 },   // Q4_0
+        {  3,  20,  32 },   // Q4_1
+        {  6,  22,  32 },   // Q5_0
+        {  7,  24,  32 },   // Q5_1
+        {  8,  34,  32 },   // Q8_0
+        { 10,  84, 256 },   // Q2_K
+        { 11, 110, 256 },   // Q3_K
+        { 12, 144, 256 },   // Q4_K
+        { 13, 176, 256 },   // Q5_K
+        { 14, 210, 256 },   // Q6_K
+        { 30,   2,   1 },   // BF16
+    };
+    for (const auto &t : kTypes)
+        if (t.type == type)
+            return elements % t.blockSize ? -1 : elements / t.blockSize * t.blockBytes;
+    return -1;
+}
+
+// Walks a whisper.cpp ggml file record by record without reading the
+// tensor data. True if every record is whole and the last tensor ends
+// exactly at the end of the file.
+static bool walkGgml(QFile &f)
+{
+    const qint64 size = f.size();
+    auto readI32 = [&f](qint32 &v) {
+        quint32 raw;
+        if (f.read(reinterpret_cast<char *>(&raw), 4) != 4)
+            return false;
+        v = qint32(qFromLittleEndian(raw));
+        return true;
+    };
+    auto skip = [&f, size](qint64 n) {
+        return n >= 0 && f.pos() + n <= size && f.skip(n) == n;
+    };
+
+    qint32 magic;
+    if (!readI32(magic) || quint32(magic) != kGgmlMagic)
+        return false;
+    for (int i = 0; i < kHparams; ++i) {
+        qint32 v;
+        if (!readI32(v))
+            return false;
+    }
+
+    qint32 nMel, nFft;
+    if (!readI32(nMel) || !readI32(nFft) || nMel < 0 || nFft < 0
+        || !skip(qint64(nMel) * nFft * 4))
+        return false;
+
+    qint32 nVocab;
+    if (!readI32(nVocab) || nVocab < 0)
+        return false;
+    for (qint32 i = 0; i < nVocab; ++i) {
+        qint32 len;
+        if (!readI32(len) || !skip(len))
+            return false;
+    }
+
+    // tensors run to EOF: n_dims, name length, type, ne[n_dims], name, data
+    while (f.pos() < size) {
+        qint32 nDims, nameLen, type;
+        if (!readI32(nDims) || !readI32(nameLen) || !readI32(type)
+            || nDims < 1 || nDims > 4 || nameLen < 1 || nameLen > 256)
+            return false;
+        qint64 elements = 1;
+        for (qint32 i = 0; i < nDims; ++i) {
+            qint32 ne;
+            if (!readI32(ne) || ne < 1)
+                return false;
+            elements *= ne;
+            if (elements > size * 8)   // no type packs tighter than this
+                return false;
+        }
+        if (!skip(nameLen) || !skip(tensorBytes(type, elements)))
+            return false;
+    }
+    return f.pos() == size;
+}
+
+ModelPrefetcher::ModelPrefetcher(QObject *parent) : QObject(parent) {}
+
+ModelPrefetcher::~ModelPrefetcher()
+{
+    cancel();
+}
+
+void ModelPrefetcher::cancel()
+{
+    if (cancelFlag)
+        *cancelFlag = true;
+    cancelFlag.reset();
+}
+
+void ModelPrefetcher::prefetch(const QString &modelPath)
+{
+    cancel();
+    auto flag = std::make_shared<std::atomic<bool>>(false);
+    cancelFlag = flag;
+
+    QPointer<ModelPrefetcher> self(this);
+    QThread *t = QThread::create([self, flag, modelPath]{
+        QElapsedTimer timer;
+        timer.start();
+
+        QFile f(modelPath);
+        Result result = f.open(QIODevice::ReadOnly) ? Ready : Unreadable;
+        const qint64 size = f.size();
+
+#ifndef Q_OS_WIN
+        // let the kernel start readahead on the whole file before we walk it
+        if (result == Ready)
+            posix_fadvise(f.handle(), 0, 0, POSIX_FADV_WILLNEED);
+#endif
+
+        if (result == Ready && !(size > 1'000'000 && walkGgml(f)))
+            result = Corrupt;
+
+        // sequential read pulls it into the page cache and proves every byte is readable
+        qint64 bytes = 0;
+        QByteArray buf(int(kChunk), Qt::Uninitialized);
+        if (result == Ready && !f.seek(0))
+            result = Unreadable;
+        while (result == Ready && !*flag) {
+            const qint64 n = f.read(buf.data(), kChunk);
+            if (n < 0)
+                result = Unreadable;
+            if (n <= 0)
+                break;
+            bytes += n;
+        }
+
+        // a download still writing it; judge it once it's done
+        if (QFileInfo(modelPath).size() != size)
+            return;
+        if (*flag || !self)
+            return;   // superseded, nobody wants the result
+        const qint64 ms = timer.elapsed();
+        QMetaObject::invokeMethod(self.data(), [self, modelPath, result, bytes, ms]{
+            if (self)
+                emit self->done(modelPath, result, bytes, ms);
+        }, Qt::QueuedConnection);
+    });
+
+    connect(t, &QThread::finished, t, &QObject::deleteLater);
+    t->start(QThread::LowPriority);
+}
@@ -0,0 +1,41 @@
+#ifndef MODELPREFETCHER_H
+#define MODELPREFETCHER_H
+
+#pragma once
+
+#include <QObject>
+#include <QString>
+#include <atomic>
+#include <memory>
+
+// Reads the model the next job will use into the OS page cache on a
+// background thread. Before that it walks the ggml layout (hparams, mel
+// filters, vocab, tensor records) and checks that the tensors end exactly
+// at the end of the file, so a truncated or damaged download is caught
+// before a job loads it. A new prefetch() cancels the one in flight within
+// one chunk read.
+class ModelPrefetcher : public QObject
+{
+    Q_OBJECT
+public:
+    enum Result {
+        Ready,
+        Unreadable,   // couldn't open or read it; may be transient
+        Corrupt       // readable, but not a whole ggml model
+    };
+
+    explicit ModelPrefetcher(QObject *parent = nullptr);
+    ~ModelPrefetcher();
+
+    void prefetch(const QString &modelPath);
+    void cancel();
+
+signals:
+    // not emitted if the file changed size meanwhile (still being written)
+    void done(const QString &modelPath, ModelPrefetcher::Result result, qint64 bytes, qint64 ms);
+
+private:
+    std::shared_ptr<std::atomic<bool>> cancelFlag;
+};
+
+#endif // MODELPREFETCHER_H
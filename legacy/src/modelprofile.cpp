@@ -0,0 +1,167 @@
+#include "modelprofile.h"
+#include <QCoreApplication>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QSettings>
+#include <QThread>
+
+#ifdef Q_OS_WIN
+#include <Windows.h>
+#else
+#include <unistd.h>
+#endif
+
+static QSettings &statsStore()
+{
+    static QSettings s(QCoreApplication::applicationDirPath() + "/settings.ini", QSettings::IniFormat);
+    return s;
+}
+
+QString ModelProfile::modelsDir()
+{
+    return QCoreApplication::applicationDirPath() + "/models/";
+}
+
+QString ModelProfile::fileFor(const QString &model, const QString &quant)
+{
+    return modelsDir() + "ggml-" + model + (quant.isEmpty() ? "" : "-" + quant) + ".bin";
+}
+
+QStringList ModelProfile::quantTypes()
+{
+    return { "q8_0", "q5_1", "q5_0", "q4_0" };
+}
+
+// approximate file size relative to the f16 release
+double ModelProfile::sizeRatio(const QString &quant)
+{
+    if (quant == "q8_0") return 0.53;
+    if (quant == "q5_1") return 0.39;
+    if (quant == "q5_0") return 0.36;
+    if (quant == "q4_0") return 0.30;
+    return 1.0;
+}
+
+qint64 ModelProfile::availableMemoryMB()
+{
+#ifdef Q_OS_WIN
+    MEMORYSTATUSEX st{};
+    st.dwLength = sizeof(st);
+    if (GlobalMemoryStatusEx(&st))
+        return qint64(st.ullAvailPhys / (1024 * 1024));
+#else
+    const long pages = sysconf(_SC_AVPHYS_PAGES);
+    const long page  = sysconf(_SC_PAGE_SIZE);
+    if (pages > 0 && page > 0)
+        return qint64(pages) * page / (1024 * 1024);
+#endif
+    return -1;   // unknown
+}
+
+QString ModelProfile::choose(const QString &model, Preference pref, bool cpuOnly)
+{
+    const QStringList ladder = QStringList{ "" } + quantTypes();
+
+    // preference sets where we start on the ladder
+    int idx = pref == Accuracy ? 0 : pref == Balanced ? 1 : 3;
+
+    // few cores on CPU-only → one step faster unless accuracy was asked for
+    if (cpuOnly && pref != Accuracy && QThread::idealThreadCount() <= 4)
+        idx = qMin(idx + 1, int(ladder.size()) - 1);
+
+    const qint64 baseMB = QFileInfo(fileFor(model)).size() / (1024 * 1024);
+    const qint64 freeMB = availableMemoryMB();
+
+    // step down until the weights + compute buffers fit in free RAM
+    if (baseMB > 0 && freeMB > 0) {
+        while (idx < ladder.size() - 1
+               && baseMB * sizeRatio(ladder[idx]) * 1.2 + 256 > freeMB)
+            ++idx;
+    }
+
+    // a variant we already measured as slower than real time → one more step
+    if (pref != Accuracy && idx < ladder.size() - 1) {
+        const QString key = "variants/" + QFileInfo(fileFor(model, ladder[idx])).fileName() + "/rtf";
+        if (statsStore().value(key, 0.0).toDouble() > 1.0)
+            ++idx;
+    }
+
+    return ladder[idx];
+}
+
+static const QStringList bySize{ "large-v3", "large-v3-turbo", "medium", "small", "base", "tiny" };
+
+bool ModelProfile::isKnownModel(const QString &model)
+{
+    QString family = model;
+    if (family.endsWith(".en") && !family.startsWith("large"))
+        family.chop(3);
+    return bySize.contains(family);
+}
+
+QStringList ModelProfile::smallerModels(const QString &model)
+{
+
+    const bool english = model.endsWith(".en");
+    QString family = model;
+    if (english)
+        family.chop(3);
+
+    QStringList paths;
+    for (int i = bySize.indexOf(family) + 1; i > 0 && i < bySize.size(); ++i) {
+        const QString en = fileFor(bySize[i] + ".en");
+        const QString multi = fileFor(bySize[i]);
+        if (english && QFileInfo::exists(en))
+            paths << en;
+        else if (QFileInfo::exists(multi))
+            paths << multi;
+    }
+    return paths;
+}
+
+void ModelProfile::record(const QString &modelPath, const QString &whisperOutput)
+{
+    static const QRegularExpression loadRe (R"(load time\s*=\s*([\d.]+)\s*ms)");
+    static const QRegularExpression totalRe(R"(total time\s*=\s*([\d.]+)\s*ms)");
+    static const QRegularExpression audioRe(R"(samples,\s*([\d.]+)\s*sec)");
+
+    const auto load  = loadRe.match(whisperOutput);
+    const auto total = totalRe.match(whisperOutput);
+    const auto audio = audioRe.match(whisperOutput);
+    if (!load.hasMatch() || !total.hasMatch() || !audio.hasMatch())
+        return;
+
+    const double audioSec = audio.captured(1).toDouble();
+    if (audioSec <= 0.0)
+        return;
+
+    QSettings &s = statsStore();
+    s.beginGroup("variants/" + QFileInfo(modelPath).fileName());
+    s.setValue("sizeMB", QFileInfo(modelPath).size() / (1024 * 1024));
+    s.setValue("loadMs", load.captured(1).toDouble());
+    s.setValue("rtf", total.captured(1).toDouble() / 1000.0 / audioSec);
+    s.endGroup();
+}
+
+QStringList ModelProfile::report(const QString &model)
+{
+    QStringList lines;
+    QSettings &s = statsStore();
+    const QStringList all = QStringList{ "" } + quantTypes();
+
+    for (const QString &quant : all) {
+        const QFileInfo fi(fileFor(model, quant));
+        if (!fi.exists())
+            continue;
+
+        const QString key = "variants/" + fi.fileName() + "/";
+        QString line = QString("%1: %2 MB").arg(quant.isEmpty() ? "f16" : quant)
+                           .arg(fi.size() / (1024 * 1024));
+        if (s.contains(key + "rtf"))
+            line += QString(", load %1 ms, RTF %2")
+                        .arg(s.value(key + "loadMs").toDouble(), 0, 'f', 0)
+                        .arg(s.value(key + "rtf").toDouble(), 0, 'f', 2);
+        lines << line;
+    }
+    return lines;
+}
@@ -0,0 +1,44 @@
+#ifndef MODELPROFILE_H
+#define MODELPROFILE_H
+
+#pragma once
+
+#include <QString>
+#include <QStringList>
+
+// Picks a quantized variant of a ggml model for this machine and keeps
+// per-variant stats (size, load time, RTF) in settings.ini.
+class ModelProfile
+{
+public:
+    enum Preference { Accuracy = 0, Balanced = 1, Speed = 2 };
+
+    static QString modelsDir();
+
+    // "" is the full-precision file, otherwise e.g. "q5_0" → ggml-<model>-q5_0.bin
+    static QString fileFor(const QString &model, const QString &quant = QString());
+    static QStringList quantTypes();   // most → least precise, excluding ""
+
+    // Chooses a quant type from free RAM, core count and the user preference.
+    // Needs the full-precision file on disk to size the variants.
+    static QString choose(const QString &model, Preference pref, bool cpuOnly);
+
+    static qint64 availableMemoryMB();
+
+    // One of the names the model box offers, e.g. "small" or "small.en".
+    static bool isKnownModel(const QString &model);
+
+    // Paths of downloaded models smaller than `model`, next-smaller first.
+    static QStringList smallerModels(const QString &model);
+
+    // Parses whisper-cli timings from a finished run and stores them for modelPath.
+    static void record(const QString &modelPath, const QString &whisperOutput);
+
+    // One line per variant that exists on disk: size, load time, RTF.
+    static QStringList report(const QString &model);
+
+private:
+    static double sizeRatio(const QString &quant);
+};
+
+#endif // MODELPROFILE_H
@@ -6,28 +6,52 @@ Settings::Settings()
 {
 }
 
-void Settings::load(QComboBox* model, QComboBox* language,
-                    QCheckBox* txt, QCheckBox* srt, QCheckBox* cpu, QCheckBox* open,
+void Settings::load(QComboBox* model, QComboBox* language, QComboBox* precision,
+                    QCheckBox* txt, QCheckBox* srt, QCheckBox* cpu, QCheckBox* open, QCheckBox* draft,
                     QPlainTextEdit* args)
 {
     model->setCurrentIndex(settings.value("model", 3).toInt());
     language->setCurrentIndex(settings.value("language", 0).toInt());
+    precision->setCurrentIndex(settings.value("precision", 1).toInt());
     txt->setChecked(settings.value("txtFile", true).toBool());
     srt->setChecked(settings.value("srtFile", false).toBool());
     cpu->setChecked(settings.value("cpuOnly", false).toBool());
     open->setChecked(settings.value("open", true).toBool());
+    draft->setChecked(settings.value("draft", false).toBool());
     args->setPlainText(settings.value("args", "-tp 0.0 -mc 64 -et 3.0").toString());
 }
 
-void Settings::save(QComboBox* model, QComboBox* language,
-                    QCheckBox* txt, QCheckBox* srt, QCheckBox* cpu, QCheckBox* open,
+void Settings::save(QComboBox* model, QComboBox* language, QComboBox* precision,
+                    QCheckBox* txt, QCheckBox* srt, QCheckBox* cpu, QCheckBox* open, QCheckBox* draft,
                     QPlainTextEdit* args)
 {
     settings.setValue("model", model->currentIndex());
     settings.setValue("language", language->currentIndex());
+    settings.setValue("precision", precision->currentIndex());
     settings.setValue("txtFile", txt->isChecked());
     settings.setValue("srtFile", srt->isChecked());
     settings.setValue("cpuOnly", cpu->isChecked());
     settings.setValue("open", open->isChecked());
+    settings.setValue("draft", draft->isChecked());
     settings.setValue("args", args->toPlainText());
 }
+
+QStringList Settings::watchFolders() const
+{
+    return settings.value("watchFolders").toStringList();
+}
+
+void Settings::setWatchFolders(const QStringList &dirs)
+{
+    settings.setValue("watchFolders", dirs);
+}
+
+QStringList Settings::workers() const
+{
+    return settings.value("workers").toStringList();
+}
+
+void Settings::setWorkers(const QStringList &hostPorts)
+{
+    settings.setValue("workers", hostPorts);
+}
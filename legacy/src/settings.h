@@ -12,14 +12,20 @@ class Settings
 public:
     Settings();
 
-    void load(QComboBox* model, QComboBox* language,
-              QCheckBox* txt, QCheckBox* srt, QCheckBox* cpu, QCheckBox* open,
+    void load(QComboBox* model, QComboBox* language, QComboBox* precision,
+              QCheckBox* txt, QCheckBox* srt, QCheckBox* cpu, QCheckBox* open, QCheckBox* draft,
               QPlainTextEdit* args);
 
-    void save(QComboBox* model, QComboBox* language,
-              QCheckBox* txt, QCheckBox* srt, QCheckBox* cpu, QCheckBox* open,
+    void save(QComboBox* model, QComboBox* language, QComboBox* precision,
+              QCheckBox* txt, QCheckBox* srt, QCheckBox* cpu, QCheckBox* open, QCheckBox* draft,
               QPlainTextEdit* args);
 
+    QStringList watchFolders() const;
+    void setWatchFolders(const QStringList &dirs);
+
+    QStringList workers() const;
+    void setWorkers(const QStringList &hostPorts);
+
 private:
     QSettings settings;
 };
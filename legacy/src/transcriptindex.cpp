@@ -0,0 +1,484 @@
+#include "transcriptindex.h"
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QMap>
+#include <QRegularExpression>
+#include <QSaveFile>
+#include <QThread>
+#include <QtEndian>
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+static constexpr int kRowBytes   = 24;
+static constexpr int kMaxBlocks  = 16;   // recent blocks before they are merged into terms.dat
+
+// terms.dat: 16-byte header (magic, version, term count, 0), then one fixed
+// entry per term in UTF-8 byte order, then the key bytes, then the postings.
+// Offsets are absolute, all integers big-endian like QDataStream writes them.
+static constexpr quint32 kTermsMagic  = 0x45575449;   // "EWTI"
+static constexpr int     kTermsHeader = 16;
+static constexpr int     kTermBytes   = 24;           // keyOff u64, keyLen u32, postOff u64, postLen u32
+
+static void putVarint(QByteArray &out, quint32 v)
+{
+    while (v >= 0x80) {
+        out.append(char(v | 0x80));
+        v >>= 7;
+    }
+    out.append(char(v));
+}
+
+// delta-encoded, ascending ids
+static QByteArray encodeIds(const QVector<quint32> &ids)
+{
+    QByteArray out;
+    quint32 prev = 0;
+    for (quint32 id : ids) {
+        putVarint(out, id - prev);
+        prev = id;
+    }
+    return out;
+}
+
+static void decodeIds(const QByteArray &in, QVector<quint32> &out)
+{
+    quint32 prev = 0, v = 0;
+    int shift = 0;
+    for (char c : in) {
+        v |= quint32(uchar(c) & 0x7F) << shift;
+        if (uchar(c) & 0x80) {
+            shift += 7;
+            continue;
+        }
+        prev += v;
+        out.append(prev);
+        v = 0;
+        shift = 0;
+    }
+}
+
+static void sortUnique(QVector<quint32> &ids)
+{
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+}
+
+static void writeBlock(QDataStream &ds, const QHash<QString, QVector<quint32>> &terms)
+{
+    ds << quint32(terms.size());
+    for (auto it = terms.cbegin(); it != terms.cend(); ++it)
+        ds << it.key() << encodeIds(it.value());
+}
+
+// Read-only, memory-mapped view of terms.dat. Only the pages a lookup
+// touches are read from disk.
+class TermsFile
+{
+public:
+    explicit TermsFile(const QString &path) : file(path)
+    {
+        if (!file.open(QIODevice::ReadOnly) || file.size() < kTermsHeader)
+            return;
+        base = file.map(0, file.size());
+        if (!base || qFromBigEndian<quint32>(base) != kTermsMagic)
+            return;
+        bytes = file.size();
+        const quint32 n = qFromBigEndian<quint32>(base + 8);
+        if (kTermsHeader + qint64(n) * kTermBytes <= bytes)
+            terms = n;
+    }
+
+    quint32 count() const { return terms; }
+
+    // both point into the mapping; copy before the TermsFile goes away
+    QByteArray key(quint32 i) const { return slice(i, 0); }
+    QByteArray postings(quint32 i) const { return slice(i, 12); }
+
+    // binary search; appends the term's segment ids to out
+    void find(const QByteArray &term, QVector<quint32> &out) const
+    {
+        quint32 lo = 0, hi = terms;
+        while (lo < hi) {
+            const quint32 mid = lo + (hi - lo) / 2;
+            const QByteArray k = key(mid);
+            const int c = std::memcmp(k.constData(), term.constData(), size_t(qMin(k.size(), term.size())));
+            const int order = c != 0 ? c : k.size() - term.size();
+            if (order == 0) {
+                decodeIds(postings(mid), out);
+                return;
+            }
+            if (order < 0)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+    }
+
+private:
+    QByteArray slice(quint32 i, int field) const
+    {
+        const uchar *e = base + kTermsHeader + qint64(i) * kTermBytes + field;
+        const quint64 off = qFromBigEndian<quint64>(e);
+        const quint32 len = qFromBigEndian<quint32>(e + 8);
+        if (off > quint64(bytes) || len > quint64(bytes) - off)
+            return QByteArray();   // torn or foreign file
+        return QByteArray::fromRawData(reinterpret_cast<const char *>(base + off), int(len));
+    }
+
+    QFile file;
+    uchar *base = nullptr;
+    qint64 bytes = 0;
+    quint32 terms = 0;
+};
+
+TranscriptIndex::TranscriptIndex(const QString &dir)
+    : dir(dir.isEmpty() ? QCoreApplication::applicationDirPath() + "/index" : dir)
+{
+}
+
+/* ---------- parsing ---------- */
+QVector<TranscriptIndex::Segment> TranscriptIndex::parseSegments(const QString &whisperOutput)
+{
+    static const QRegularExpression line(
+        R"(^\[(\d+):(\d{2}):(\d{2})\.(\d{3}) --> (\d+):(\d{2}):(\d{2})\.(\d{3})\]\s*(.*)$)",
+        QRegularExpression::MultilineOption);
+
+    auto ms = [](const QRegularExpressionMatch &m, int first) {
+        return ((m.captured(first).toLongLong() * 60 + m.captured(first + 1).toLongLong()) * 60
+                + m.captured(first + 2).toLongLong()) * 1000 + m.captured(first + 3).toLongLong();
+    };
+
+    QVector<Segment> segments;
+    for (auto it = line.globalMatch(whisperOutput); it.hasNext(); ) {
+        const auto m = it.next();
+        const QString text = m.captured(9).trimmed();
+        if (!text.isEmpty())
+            segments.append({ ms(m, 1), ms(m, 5), text });
+    }
+    return segments;
+}
+
+QString TranscriptIndex::formatTime(qint64 ms)
+{
+    return QString("%1:%2:%3.%4")
+        .arg(ms / 3'600'000, 2, 10, QChar('0'))
+        .arg(ms / 60'000 % 60, 2, 10, QChar('0'))
+        .arg(ms / 1000 % 60, 2, 10, QChar('0'))
+        .arg(ms % 1000, 3, 10, QChar('0'));
+}
+
+QStringList TranscriptIndex::tokenize(const QString &text)
+{
+    static const QRegularExpression nonWord(R"([^\p{L}\p{N}]+)");
+    return text.toLower().split(nonWord, Qt::SkipEmptyParts);
+}
+
+/* ---------- storage ---------- */
+TranscriptIndex::~TranscriptIndex()
+{
+    reapMerge(true);
+}
+
+void TranscriptIndex::loadDocs()
+{
+    if (docsLoaded)
+        return;
+    docsLoaded = true;
+
+    QFile docs(dir + "/docs.dat");
+    if (!docs.open(QIODevice::ReadOnly))
+        return;
+    QDataStream ds(&docs);
+    ds.setVersion(QDataStream::Qt_5_12);
+    while (!ds.atEnd()) {
+        quint32 id;
+        QString path;
+        ds >> id >> path;
+        if (ds.status() != QDataStream::Ok)
+            break;   // torn by a crash; add() cuts it off
+        docPath.insert(id, path);
+        latestDoc.insert(path, id);
+        docsEnd = docs.pos();
+    }
+}
+
+// Decodes the postings.dat blocks for the terms in `only` (every term if
+// null), stopping at byte `upTo` if given. Returns the number of complete
+// blocks; *validEnd gets the offset just past the last one.
+int TranscriptIndex::readRecent(const QString &dir, const QSet<QString> *only,
+                                QHash<QString, QVector<quint32>> &out,
+                                qint64 upTo, qint64 *validEnd)
+{
+    if (validEnd)
+        *validEnd = 0;
+    QFile post(dir + "/postings.dat");
+    if (!post.open(QIODevice::ReadOnly))
+        return 0;
+
+    int n = 0;
+    QDataStream ds(&post);
+    ds.setVersion(QDataStream::Qt_5_12);
+    while (!ds.atEnd() && (upTo < 0 || post.pos() < upTo)) {
+        quint32 terms;
+        ds >> terms;
+        for (quint32 i = 0; i < terms && ds.status() == QDataStream::Ok; ++i) {
+            QString term;
+            QByteArray ids;
+            ds >> term >> ids;
+            if (!only || only->contains(term))
+                decodeIds(ids, out[term]);
+        }
+        if (ds.status() != QDataStream::Ok)
+            break;
+        ++n;
+        if (validEnd)
+            *validEnd = post.pos();
+    }
+    return n;
+}
+
+// Runs on the merge thread: folds postings.dat up to `upTo` into a new
+// terms.dat. The swap fails while a reader has the old one mapped; the
+// blocks then stay put and a later add() tries again.
+bool TranscriptIndex::writeMerged(const QString &dir, qint64 upTo)
+{
+    QMap<QByteArray, QVector<quint32>> all;   // UTF-8 byte order, as TermsFile::find expects
+    {
+        const TermsFile terms(dir + "/terms.dat");
+        for (quint32 i = 0; i < terms.count(); ++i) {
+            const QByteArray k = terms.key(i);
+            decodeIds(terms.postings(i), all[QByteArray(k.constData(), k.size())]);
+        }
+    }
+    QHash<QString, QVector<quint32>> recent;
+    readRecent(dir, nullptr, recent, upTo);
+    for (auto it = recent.cbegin(); it != recent.cend(); ++it)
+        all[it.key().toUtf8()] += it.value();
+
+    QByteArray keys, posts;
+    QVector<quint64> keyAt, postAt;
+    for (auto it = all.begin(); it != all.end(); ++it) {
+        sortUnique(it.value());
+        keyAt.append(quint64(keys.size()));
+        keys += it.key();
+        postAt.append(quint64(posts.size()));
+        posts += encodeIds(it.value());
+    }
+
+    QSaveFile out(dir + "/terms.dat");
+    if (!out.open(QIODevice::WriteOnly))
+        return false;
+    QDataStream ds(&out);
+    ds << kTermsMagic << quint32(1) << quint32(all.size()) << quint32(0);
+
+    const quint64 keysStart  = kTermsHeader + quint64(all.size()) * kTermBytes;
+    const quint64 postsStart = keysStart + quint64(keys.size());
+    int i = 0;
+    for (auto it = all.cbegin(); it != all.cend(); ++it, ++i) {
+        const quint64 postEnd = i + 1 < all.size() ? postAt[i + 1] : quint64(posts.size());
+        ds << keysStart + keyAt[i] << quint32(it.key().size())
+           << postsStart + postAt[i] << quint32(postEnd - postAt[i]);
+    }
+    out.write(keys);
+    out.write(posts);
+    return out.commit();
+}
+
+// The dictionary rewrite is proportional to the whole index, so it runs
+// on its own thread. add() keeps appending meanwhile; only the blocks that
+// were there when the merge started are dropped afterwards.
+void TranscriptIndex::startMerge()
+{
+    mergeUpTo = postingsEnd;
+    mergeBlocks = blocks;
+    mergeOk = false;
+    const QString d = dir;
+    const qint64 upTo = mergeUpTo;
+    mergeThread = QThread::create([this, d, upTo]{ mergeOk = writeMerged(d, upTo); });
+    mergeThread->start(QThread::LowPriority);
+}
+
+// Picks up a finished merge (or waits for it). Readers drop duplicate ids,
+// so a crash before postings.dat is trimmed costs nothing but a re-merge.
+void TranscriptIndex::reapMerge(bool wait)
+{
+    if (!mergeThread || (!wait && !mergeThread->isFinished()))
+        return;
+    mergeThread->wait();
+    delete mergeThread;
+    mergeThread = nullptr;
+    if (!mergeOk)
+        return;
+
+    // keep whatever was appended after the merge started
+    QFile post(dir + "/postings.dat");
+    if (!post.open(QIODevice::ReadOnly) || !post.seek(mergeUpTo))
+        return;
+    const QByteArray tail = post.read(postingsEnd - mergeUpTo);
+    post.close();
+
+    QSaveFile trimmed(dir + "/postings.dat");
+    if (!trimmed.open(QIODevice::WriteOnly))
+        return;
+    trimmed.write(tail);
+    if (!trimmed.commit())
+        return;
+    postingsEnd = tail.size();
+    blocks -= mergeBlocks;
+}
+
+void TranscriptIndex::add(const QString &sourceFile, const QVector<Segment> &segments)
+{
+    loadDocs();
+    reapMerge(false);
+    if (segments.isEmpty())
+        return;
+    QDir().mkpath(dir);
+
+    if (blocks < 0) {
+        const QSet<QString> none;
+        QHash<QString, QVector<quint32>> unused;
+        blocks = readRecent(dir, &none, unused, -1, &postingsEnd);
+    }
+
+    const quint32 docId = docPath.isEmpty()
+                              ? 0
+                              : *std::max_element(docPath.keyBegin(), docPath.keyEnd()) + 1;
+
+    QFile text(dir + "/segments.txt");
+    QFile idx(dir + "/segments.idx");
+    QFile post(dir + "/postings.dat");
+    QFile docs(dir + "/docs.dat");
+    if (!text.open(QIODevice::Append) || !idx.open(QIODevice::Append)
+        || !post.open(QIODevice::Append) || !docs.open(QIODevice::Append))
+        return;
+
+    // cut off records torn by an earlier crash; appending after them would
+    // leave every later record unreadable
+    if (docs.size() != docsEnd)
+        docs.resize(docsEnd);
+    if (post.size() != postingsEnd)
+        post.resize(postingsEnd);
+
+    // claim the docId first so a crash can't hand its rows to the next job
+    QDataStream docsOut(&docs);
+    docsOut.setVersion(QDataStream::Qt_5_12);
+    docsOut << docId << sourceFile;
+    docsEnd = docs.size();
+    docPath.insert(docId, sourceFile);
+    latestDoc.insert(sourceFile, docId);
+
+    // drop a torn row left by an earlier crash so new rows stay aligned
+    const qint64 rowCount = idx.size() / kRowBytes;
+    if (idx.size() != rowCount * kRowBytes)
+        idx.resize(rowCount * kRowBytes);
+
+    QDataStream idxOut(&idx);
+    quint64 offset = quint64(text.size());
+    QHash<QString, QVector<quint32>> block;
+
+    for (int i = 0; i < segments.size(); ++i) {
+        const Segment &s = segments[i];
+        const QByteArray utf8 = s.text.toUtf8();
+        text.write(utf8);
+
+        const quint32 segId = quint32(rowCount + i);
+        idxOut << docId << quint32(s.startMs) << quint32(s.endMs) << offset << quint32(utf8.size());
+        offset += utf8.size();
+
+        QSet<QString> seen;
+        for (const QString &term : tokenize(s.text))
+            if (!seen.contains(term)) {
+                seen.insert(term);
+                block[term].append(segId);
+            }
+    }
+
+    QDataStream postOut(&post);
+    postOut.setVersion(QDataStream::Qt_5_12);
+    writeBlock(postOut, block);
+    postingsEnd = post.size();
+    ++blocks;
+
+    post.close();
+    if (blocks >= kMaxBlocks && !mergeThread)
+        startMerge();
+}
+
+/* ---------- query ---------- */
+QVector<TranscriptIndex::Hit> TranscriptIndex::search(const QString &phrase, int limit)
+{
+    loadDocs();
+    QVector<Hit> hits;
+    const QStringList terms = tokenize(phrase);
+    if (terms.isEmpty())
+        return hits;
+
+    // each term: its terms.dat entry plus whatever recent blocks mention it
+    const QSet<QString> wanted(terms.cbegin(), terms.cend());
+    QHash<QString, QVector<quint32>> lists;
+    readRecent(dir, &wanted, lists);
+    {
+        const TermsFile dict(dir + "/terms.dat");
+        for (const QString &t : wanted) {
+            QVector<quint32> &ids = lists[t];
+            dict.find(t.toUtf8(), ids);
+            sortUnique(ids);
+            if (ids.isEmpty())
+                return hits;
+        }
+    }
+
+    // intersect posting lists, shortest first
+    QVector<const QVector<quint32> *> sorted;
+    for (const QVector<quint32> &ids : lists)
+        sorted.append(&ids);
+    std::sort(sorted.begin(), sorted.end(),
+              [](auto *a, auto *b) { return a->size() < b->size(); });
+
+    QVector<quint32> candidates = *sorted.first();
+    for (int i = 1; i < sorted.size() && !candidates.isEmpty(); ++i) {
+        QVector<quint32> both;
+        std::set_intersection(candidates.cbegin(), candidates.cend(),
+                              sorted[i]->cbegin(), sorted[i]->cend(), std::back_inserter(both));
+        candidates.swap(both);
+    }
+
+    QFile idx(dir + "/segments.idx");
+    QFile text(dir + "/segments.txt");
+    if (!idx.open(QIODevice::ReadOnly) || !text.open(QIODevice::ReadOnly))
+        return hits;
+    const qint64 rowCount = idx.size() / kRowBytes;   // ignores a torn last row
+
+    // newest first; confirm word order against the stored text
+    for (int i = candidates.size() - 1; i >= 0 && hits.size() < limit; --i) {
+        const quint32 segId = candidates[i];
+        if (segId >= rowCount || !idx.seek(qint64(segId) * kRowBytes))
+            continue;
+        QDataStream row(idx.read(kRowBytes));
+        quint32 docId, startMs, endMs, length;
+        quint64 offset;
+        row >> docId >> startMs >> endMs >> offset >> length;
+        if (row.status() != QDataStream::Ok)
+            continue;
+
+        const QString file = docPath.value(docId);
+        if (file.isEmpty() || latestDoc.value(file) != docId)
+            continue;   // superseded by a re-transcription
+        if (!text.seek(qint64(offset)))
+            continue;
+
+        const QString segment = QString::fromUtf8(text.read(length));
+        const QStringList words = tokenize(segment);
+        for (int w = 0; w + terms.size() <= words.size(); ++w) {
+            if (std::equal(terms.cbegin(), terms.cend(), words.cbegin() + w)) {
+                hits.append({ file, startMs, endMs, segment });
+                break;
+            }
+        }
+    }
+    return hits;
+}
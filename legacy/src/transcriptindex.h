@@ -0,0 +1,76 @@
+#ifndef TRANSCRIPTINDEX_H
+#define TRANSCRIPTINDEX_H
+
+#pragma once
+
+#include <QHash>
+#include <QSet>
+#include <QVector>
+#include <QStringList>
+#include <atomic>
+
+class QThread;
+
+// On-disk inverted index over transcript segments, stored in <app>/index/:
+//   docs.dat      (docId, source path) log; re-indexing a path supersedes it
+//   segments.idx  fixed 24-byte rows: docId, startMs, endMs, text offset, length
+//   segments.txt  UTF-8 segment text
+//   postings.dat  recent jobs, one block each: term → delta/varint segment ids
+//   terms.dat     merged postings behind a sorted, fixed-width term dictionary
+// add() only appends. Once postings.dat holds 16 blocks, a background
+// thread merges them into a new terms.dat and swaps it in. search() never
+// writes. It binary searches terms.dat through a memory map, so a query
+// reads only its own postings, the short postings.dat tail and the rows it
+// returns.
+class TranscriptIndex
+{
+public:
+    struct Segment {
+        qint64 startMs = 0;
+        qint64 endMs = 0;
+        QString text;
+    };
+
+    struct Hit {
+        QString file;
+        qint64 startMs = 0;
+        qint64 endMs = 0;
+        QString text;
+    };
+
+    explicit TranscriptIndex(const QString &dir = QString());
+    ~TranscriptIndex();
+
+    // "[00:00:01.000 --> 00:00:04.000]  text" lines from whisper-cli output
+    static QVector<Segment> parseSegments(const QString &whisperOutput);
+    static QString formatTime(qint64 ms);
+
+    void add(const QString &sourceFile, const QVector<Segment> &segments);
+    QVector<Hit> search(const QString &phrase, int limit = 100);
+
+private:
+    static QStringList tokenize(const QString &text);
+    static int readRecent(const QString &dir, const QSet<QString> *only,
+                          QHash<QString, QVector<quint32>> &out,
+                          qint64 upTo = -1, qint64 *validEnd = nullptr);
+    static bool writeMerged(const QString &dir, qint64 upTo);
+    void loadDocs();
+    void startMerge();
+    void reapMerge(bool wait);
+
+    QString dir;
+    bool docsLoaded = false;
+    qint64 docsEnd = 0;                     // end of the last complete docs.dat record
+    int blocks = -1;                        // postings.dat blocks, -1 = not counted yet
+    qint64 postingsEnd = 0;                 // end of the last complete postings.dat block
+
+    QThread *mergeThread = nullptr;
+    qint64 mergeUpTo = 0;                   // postings.dat bytes the running merge covers
+    int mergeBlocks = 0;
+    std::atomic<bool> mergeOk{ false };
+
+    QHash<quint32, QString> docPath;        // docId → path
+    QHash<QString, quint32> latestDoc;      // path → current docId
+};
+
+#endif // TRANSCRIPTINDEX_H
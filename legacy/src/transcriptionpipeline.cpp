@@ -9,15 +9,32 @@
 #include <QTimer>
 #include <QUrl>
 #include <QFile>
+#include <QThread>
+#include <QTextCursor>
+#include <QTextDocument>
+#include <QElapsedTimer>
+#include "modelprofile.h"
+#include "transcriptindex.h"
+
+// upper bound on cancel(): kill, then wait this long for the processes to exit
+static constexpr int kStopBoundMs = 500;
+
+// tiny is the fastest to load; keep English-only if the user picked it
+static QString draftModelFor(const QString &model)
+{
+    return model.endsWith(".en") ? "tiny.en" : "tiny";
+}
 
 TranscriptionPipeline::TranscriptionPipeline(
     QPlainTextEdit  *console,
     QComboBox       *model,
     QComboBox       *language,
+    QComboBox       *precision,
     QCheckBox       *txtCheckbox,
     QCheckBox       *srtCheckbox,
     QCheckBox       *cpuCheckbox,
     QCheckBox       *openCheckbox,
+    QCheckBox       *draftCheckbox,
     QPlainTextEdit  *arguments,
     QList<QProcess*> *processList,
     QObject *parent)
@@ -25,33 +42,131 @@ TranscriptionPipeline::TranscriptionPipeline(
     console(console),
     model(model),
     language(language),
+    precision(precision),
     txtCheckbox(txtCheckbox),
     srtCheckbox(srtCheckbox),
     cpuCheckbox(cpuCheckbox),
     openCheckbox(openCheckbox),
+    draftCheckbox(draftCheckbox),
     arguments(arguments),
     processList(processList)
 {}
 
 /* ---------- public entry ---------- */
-void TranscriptionPipeline::start(const QString &inputPath)
+void TranscriptionPipeline::start(const QString &inputPath, const CancelToken &jobToken)
 {
+    running = true;
+    jobProcs.clear();
+    partials.clear();
+
     QFileInfo fi(inputPath);
     if (inputPath.isEmpty() || !fi.exists()) {
         console->appendPlainText("Error: media file not found.");
-        emit finished();
+        finish();
         return;
     }
 
     srcFile   = fi.absoluteFilePath();
     mp3File   = fi.absolutePath() + "/" + fi.completeBaseName() + ".mp3";
     outputTxt = mp3File + ".txt";
+    // no draft pass when the draft model is the one selected
+    drafting  = draftCheckbox->isChecked() && model->currentText() != draftModelFor(model->currentText());
+    wavFile   = drafting ? mp3File + ".16k.wav" : QString();
 
     console->appendPlainText("Input file: " + srcFile);
 
-    (fi.suffix().compare("mp3", Qt::CaseInsensitive) == 0)
-        ? checkModel()
-        : convertToMp3();
+    token = jobToken;
+    const int id = ++job;
+    token.onCancel([this, id]{
+        if (id == job && running)
+            abort();
+    });
+    if (token.isCancelled())
+        return;   // abort() already ran
+
+    const bool convert = fi.suffix().compare("mp3", Qt::CaseInsensitive) != 0;
+    if (convert)
+        partials << mp3File;
+    if (drafting)
+        partials << wavFile;
+
+    if (convert)
+        convertToMp3();
+    else if (drafting)
+        decodeWav();
+    else
+        checkModel();
+}
+
+/* ---------- cancellation ---------- */
+void TranscriptionPipeline::track(QProcess *p)
+{
+    processList->append(p);
+    jobProcs << p;
+}
+
+// whisper-cli has no way to be told to stop between segments, so
+// cancelling a step means ending its process
+void TranscriptionPipeline::abort()
+{
+    QElapsedTimer t;
+    t.start();
+
+    for (const QPointer<QProcess> &p : jobProcs)
+        if (p)
+            reap(p);
+    // one shared deadline, so a stop never takes longer than kStopBoundMs
+    for (const QPointer<QProcess> &p : jobProcs)
+        if (p && p->state() != QProcess::NotRunning)
+            p->waitForFinished(qMax<qint64>(1, kStopBoundMs - t.elapsed()));
+    jobProcs.clear();
+    draftProc = nullptr;
+
+    // the killed processes held these open, so only now can they go
+    for (const QString &path : partials)
+        QFile::remove(path);
+    partials.clear();
+    dropDrafts();
+    draftBuf.clear();
+    refineBuf.clear();
+
+    console->appendPlainText(QString("Cancelled %1 (%2 ms).")
+                                 .arg(QFileInfo(srcFile).fileName()).arg(t.elapsed()));
+    finish();
+}
+
+void TranscriptionPipeline::finish()
+{
+    // the draft pass, or its model download, can still be running when
+    // refine ends; nothing of this job may outlive it
+    for (const QPointer<QProcess> &p : jobProcs)
+        if (p && p->state() != QProcess::NotRunning)
+            reap(p);
+    jobProcs.clear();
+    draftProc = nullptr;
+
+    running = false;
+    partials.clear();
+    emit finished();
+}
+
+// Detach first so no finished handler of ours starts another step, then
+// kill. Connections with the process itself as context still run.
+void TranscriptionPipeline::reap(QProcess *p)
+{
+    p->disconnect(this);
+    processList->removeOne(p);
+    if (p->state() == QProcess::NotRunning) {
+        p->deleteLater();
+        return;
+    }
+    connect(p, QOverload<int,QProcess::ExitStatus>::of(&QProcess::finished), p, &QObject::deleteLater);
+    p->kill();
+}
+
+void TranscriptionPipeline::clearDrafts()
+{
+    drafts.clear();
 }
 
 /* ---------- step 1 : convert (128 kbps) ---------- */
@@ -59,9 +174,12 @@ void TranscriptionPipeline::convertToMp3()
 {
     console->appendPlainText("Converting → 128 kbps MP3 …");
     QStringList args{ "-y", "-i", srcFile, "-b:a", "128k", mp3File };
+    // draft mode: same decode also writes the WAV both whisper passes read
+    if (drafting)
+        args << "-ar" << "16000" << "-ac" << "1" << "-c:a" << "pcm_s16le" << wavFile;
 
     auto *p = new QProcess(this);
-    processList->append(p);
+    track(p);
     p->setProcessChannelMode(QProcess::MergedChannels);
 
     connect(p, &QProcess::readyRead,
@@ -72,11 +190,42 @@ void TranscriptionPipeline::convertToMp3()
                 processList->removeOne(p);  p->deleteLater();
                 if (st==QProcess::NormalExit && code==0) {
                     console->appendPlainText("FFmpeg OK.");
+                    if (drafting)
+                        startDraft();
                     checkModel();
                 } else {
                     console->appendPlainText("FFmpeg failed.");
-                    emit finished();
+                    finish();
+                }
+            });
+    p->start("ffmpeg", args);
+}
+
+/* ---------- step 1b : mp3 input in draft mode → shared WAV ---------- */
+void TranscriptionPipeline::decodeWav()
+{
+    console->appendPlainText("Decoding → 16 kHz WAV …");
+    QStringList args{ "-y", "-i", srcFile, "-ar", "16000", "-ac", "1", "-c:a", "pcm_s16le", wavFile };
+
+    auto *p = new QProcess(this);
+    track(p);
+    p->setProcessChannelMode(QProcess::MergedChannels);
+
+    connect(p, &QProcess::readyRead,
+            this, [=]{ console->appendPlainText(QString::fromLocal8Bit(p->readAll())); });
+
+    connect(p, QOverload<int,QProcess::ExitStatus>::of(&QProcess::finished),
+            this, [=](int code, QProcess::ExitStatus st){
+                processList->removeOne(p);  p->deleteLater();
+                if (st==QProcess::NormalExit && code==0) {
+                    startDraft();
+                } else {
+                    // no WAV → plain single pass on the mp3
+                    console->appendPlainText("FFmpeg decode failed, skipping draft.");
+                    drafting = false;
+                    wavFile.clear();
                 }
+                checkModel();
             });
     p->start("ffmpeg", args);
 }
@@ -85,14 +234,14 @@ void TranscriptionPipeline::convertToMp3()
 void TranscriptionPipeline::checkModel()
 {
     const QString modelFile = "ggml-" + model->currentText() + ".bin";
-    const QString modelsDir = QCoreApplication::applicationDirPath() + "/models/";
-    const QString modelPath = modelsDir + modelFile;
+    const QString modelsDir = ModelProfile::modelsDir();
+    const QString basePath  = modelsDir + modelFile;
 
     QDir().mkpath(modelsDir);
 
-    if (QFile::exists(modelPath)) {
+    if (QFile::exists(basePath)) {
         console->appendPlainText("Model OK: " + modelFile);
-        runWhisper();
+        selectVariant();
         return;
     }
 
@@ -100,7 +249,8 @@ void TranscriptionPipeline::checkModel()
     const QString url = "https://huggingface.co/ggerganov/whisper.cpp/resolve/main/" + modelFile;
 
     auto *p = new QProcess(this);
-    processList->append(p);
+    track(p);
+    partials << basePath;
     p->setProcessChannelMode(QProcess::MergedChannels);
 
     connect(p, &QProcess::readyRead,
@@ -109,56 +259,293 @@ void TranscriptionPipeline::checkModel()
     connect(p, QOverload<int,QProcess::ExitStatus>::of(&QProcess::finished),
             this, [=](int code, QProcess::ExitStatus st){
                 processList->removeOne(p);  p->deleteLater();
-                if (st==QProcess::NormalExit && code==0 && QFileInfo(modelPath).size() > 1'000'000) {
+                partials.removeOne(basePath);
+                if (st==QProcess::NormalExit && code==0 && QFileInfo(basePath).size() > 1'000'000) {
                     console->appendPlainText("Model download OK.");
-                    runWhisper();
+                    selectVariant();
                 } else {
                     console->appendPlainText("Model download failed.");
-                    QFile::remove(modelPath);
-                    emit finished();
+                    QFile::remove(basePath);
+                    finish();
+                }
+            });
+    p->start("curl", { "-L", url, "-o", basePath });
+}
+
+/* ---------- step 2b : pick / build quantized variant ---------- */
+void TranscriptionPipeline::selectVariant()
+{
+    const QString name  = model->currentText();
+    const QString quant = ModelProfile::choose(name,
+                                               ModelProfile::Preference(precision->currentIndex()),
+                                               cpuCheckbox->isChecked());
+
+    console->appendPlainText(QString("Free RAM: %1 MB, variant: %2")
+                                 .arg(ModelProfile::availableMemoryMB())
+                                 .arg(quant.isEmpty() ? "f16" : quant));
+
+    modelPath = ModelProfile::fileFor(name, quant);
+    if (QFile::exists(modelPath)) {
+        runWhisper();
+        return;
+    }
+    quantizeModel(quant);
+}
+
+void TranscriptionPipeline::quantizeModel(const QString &quant)
+{
+    const QString basePath   = ModelProfile::fileFor(model->currentText());
+    const QString outPath    = modelPath;
+    // selectVariant trusts any file under the final name, so only a checked
+    // result gets renamed there; a quit mid-quantize leaves just the .part
+    const QString partPath   = outPath + ".part";
+    const QString quantizeExe = QCoreApplication::applicationDirPath() + "/whisper-quantize.exe";
+
+    console->appendPlainText("Quantizing model → " + quant + " …");
+
+    auto *p = new QProcess(this);
+    track(p);
+    partials << partPath;
+    p->setProcessChannelMode(QProcess::MergedChannels);
+
+    connect(p, &QProcess::readyRead,
+            this, [=]{ console->appendPlainText(QString::fromLocal8Bit(p->readAll())); });
+
+    connect(p, QOverload<int,QProcess::ExitStatus>::of(&QProcess::finished),
+            this, [=](int code, QProcess::ExitStatus st){
+                processList->removeOne(p);  p->deleteLater();
+                partials.removeOne(partPath);
+                if (st==QProcess::NormalExit && code==0 && QFileInfo(partPath).size() > 1'000'000
+                    && QFile::rename(partPath, outPath)) {
+                    console->appendPlainText("Quantize OK.");
+                } else {
+                    // keep going on the full-precision model rather than failing the job
+                    console->appendPlainText("Quantize failed, using full-precision model.");
+                    QFile::remove(partPath);
+                    modelPath = basePath;
                 }
+                runWhisper();
             });
-    p->start("curl", { "-L", url, "-o", modelPath });
+    p->start(quantizeExe, { basePath, partPath, quant });
 }
 
 /* ---------- step 3 : whisper ---------- */
 void TranscriptionPipeline::runWhisper()
 {
     const QString exeDir = QCoreApplication::applicationDirPath();
-    const QString modelPath = exeDir + "/models/ggml-" + model->currentText() + ".bin";
     const QString whisperExe = exeDir + "/whisper-cli.exe";
 
     QStringList cmd{
         "-m", modelPath,
-        "-f", mp3File,
+        "-f", drafting ? wavFile : mp3File,
         (txtCheckbox->isChecked()? "-otxt" : ""),
         (srtCheckbox->isChecked()? "-osrt" : ""),
         (cpuCheckbox->isChecked()? "--no-gpu" : ""),
         "-l", language->currentText()
     };
+    if (drafting)
+        cmd << "-of" << mp3File;   // keep <name>.mp3.txt / .srt naming
     cmd += QProcess::splitCommand(arguments->toPlainText());
 
-    console->appendPlainText("Running whisper-cli …");
+    console->appendPlainText(drafting ? "Refining with " + model->currentText() + " …"
+                                      : "Running whisper-cli …");
+    whisperLog.clear();
+    refineBuf.clear();
 
     auto *p = new QProcess(this);
-    processList->append(p);
+    track(p);
     p->setProcessChannelMode(QProcess::MergedChannels);
 
     connect(p, &QProcess::readyRead,
-            this, [=]{ console->appendPlainText(QString::fromLocal8Bit(p->readAll())); });
+            this, [=]{
+                const QString out = QString::fromLocal8Bit(p->readAll());
+                whisperLog += out;
+                if (!drafting) {
+                    console->appendPlainText(out);
+                    return;
+                }
+                refineBuf += out;
+                const int cut = refineBuf.lastIndexOf('\n');
+                if (cut < 0)
+                    return;
+                for (const QString &line : refineBuf.left(cut).split('\n'))
+                    showRefined(line.trimmed());
+                refineBuf.remove(0, cut + 1);
+            });
 
     connect(p, QOverload<int,QProcess::ExitStatus>::of(&QProcess::finished),
             this, [=](int code, QProcess::ExitStatus st){
                 processList->removeOne(p);  p->deleteLater();
 
+                if (drafting) {
+                    showRefined(refineBuf.trimmed());
+                    refineBuf.clear();
+                    // refine won the race. Windows won't delete the WAV while
+                    // the draft whisper-cli still has it open, so reap it first
+                    if (QProcess *d = draftProc) {
+                        draftProc = nullptr;
+                        reap(d);
+                        if (!d->waitForFinished(kStopBoundMs)) {
+                            const QString wav = wavFile;
+                            connect(d, QOverload<int,QProcess::ExitStatus>::of(&QProcess::finished),
+                                    d, [wav]{ QFile::remove(wav); });
+                        }
+                    }
+                    QFile::remove(wavFile);
+                }
+
                 if (st==QProcess::NormalExit && code==0) {
+                    dropDrafts();
                     console->appendPlainText("Whisper DONE.");
+                    ModelProfile::record(modelPath, whisperLog);
+                    for (const QString &line : ModelProfile::report(model->currentText()))
+                        console->appendPlainText("  " + line);
+                    emit transcribed(srcFile, whisperLog);
                     if (txtCheckbox->isChecked() && openCheckbox->isChecked())
                         QTimer::singleShot(1500, [=]{ QProcess::startDetached("notepad.exe", { outputTxt }); });
                 } else {
                     console->appendPlainText("Whisper failed.");
                 }
-                emit finished();
+                finish();
             });
     p->start(whisperExe, cmd);
 }
+
+/* ---------- draft pass ---------- */
+void TranscriptionPipeline::startDraft()
+{
+    drafts.clear();
+    draftBuf.clear();
+
+    const QString name = draftModelFor(model->currentText());
+    const QString draftModel = ModelProfile::fileFor(name);
+
+    if (QFile::exists(draftModel)) {
+        runDraft(draftModel);
+        return;
+    }
+
+    const QString url = "https://huggingface.co/ggerganov/whisper.cpp/resolve/main/ggml-" + name + ".bin";
+    QDir().mkpath(ModelProfile::modelsDir());
+
+    const QString part = draftModel + ".part";
+    auto *p = new QProcess(this);
+    track(p);
+
+    connect(p, QOverload<int,QProcess::ExitStatus>::of(&QProcess::finished),
+            this, [=](int code, QProcess::ExitStatus st){
+                processList->removeOne(p);  p->deleteLater();
+                // draft is best-effort
+                if (st==QProcess::NormalExit && code==0 && QFileInfo(part).size() > 1'000'000
+                    && QFile::rename(part, draftModel))
+                    runDraft(draftModel);
+            });
+    // runs after the handler above; context `p`, so it also runs when the
+    // job ends first and reaps the download
+    connect(p, QOverload<int,QProcess::ExitStatus>::of(&QProcess::finished),
+            p, [part]{ QFile::remove(part); });
+    p->start("curl", { "-L", url, "-o", part });
+}
+
+void TranscriptionPipeline::runDraft(const QString &draftModel)
+{
+    if (!drafting || !QFile::exists(wavFile))
+        return;   // refine already finished
+
+    console->appendPlainText("Draft with " + QFileInfo(draftModel).completeBaseName() + " …");
+
+    // leave most cores to the refine pass
+    const int threads = qMax(1, QThread::idealThreadCount() / 4);
+    QStringList cmd{
+        "-m", draftModel,
+        "-f", wavFile,
+        "-t", QString::number(threads),
+        (cpuCheckbox->isChecked()? "--no-gpu" : ""),
+        "-l", language->currentText()
+    };
+
+    auto *p = new QProcess(this);
+    draftProc = p;
+    track(p);
+    p->setProcessChannelMode(QProcess::MergedChannels);
+
+    connect(p, &QProcess::readyRead,
+            this, [=]{
+                draftBuf += QString::fromLocal8Bit(p->readAll());
+                const int cut = draftBuf.lastIndexOf('\n');
+                if (cut < 0)
+                    return;
+                for (const QString &line : draftBuf.left(cut).split('\n'))
+                    showDraft(line.trimmed());
+                draftBuf.remove(0, cut + 1);
+            });
+
+    connect(p, QOverload<int,QProcess::ExitStatus>::of(&QProcess::finished),
+            this, [=]{
+                processList->removeOne(p);  p->deleteLater();
+                draftProc = nullptr;
+            });
+    p->start(QCoreApplication::applicationDirPath() + "/whisper-cli.exe", cmd);
+}
+
+// draft segments go straight to the console and are remembered by time range
+void TranscriptionPipeline::showDraft(const QString &line)
+{
+    const auto segs = TranscriptIndex::parseSegments(line);
+    if (segs.isEmpty())
+        return;   // model load / timing noise
+
+    console->appendPlainText("[draft] " + line);
+    drafts.append({ segs.first().startMs, segs.first().endMs, console->document()->lastBlock() });
+}
+
+// a refined segment takes the place of the first draft line it overlaps;
+// the other overlapped draft lines are removed
+void TranscriptionPipeline::showRefined(const QString &line)
+{
+    if (line.isEmpty())
+        return;
+    const auto segs = TranscriptIndex::parseSegments(line);
+    if (segs.isEmpty()) {
+        console->appendPlainText(line);
+        return;
+    }
+
+    bool placed = false;
+    for (int i = 0; i < drafts.size(); ) {
+        const DraftLine &d = drafts[i];
+        const bool overlaps = d.startMs < segs.first().endMs && d.endMs > segs.first().startMs;
+        if (!overlaps || !d.block.isValid()) {
+            ++i;
+            continue;
+        }
+
+        QTextCursor c(d.block);
+        if (!placed) {
+            c.movePosition(QTextCursor::StartOfBlock);
+            c.movePosition(QTextCursor::EndOfBlock, QTextCursor::KeepAnchor);
+            c.insertText(line);
+            placed = true;
+        } else {
+            c.select(QTextCursor::BlockUnderCursor);
+            c.removeSelectedText();
+        }
+        drafts.removeAt(i);
+    }
+
+    if (!placed)
+        console->appendPlainText(line);
+}
+
+void TranscriptionPipeline::dropDrafts()
+{
+    // whatever the refine pass never overlapped was a draft-only hallucination
+    for (const DraftLine &d : drafts) {
+        if (!d.block.isValid())
+            continue;
+        QTextCursor c(d.block);
+        c.select(QTextCursor::BlockUnderCursor);
+        c.removeSelectedText();
+    }
+    drafts.clear();
+}
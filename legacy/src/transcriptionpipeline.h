@@ -1,10 +1,14 @@
 #pragma once
 #include <QObject>
+#include <QPointer>
+#include <QProcess>
+#include <QTextBlock>
+#include <QVector>
+#include "canceltoken.h"
 
 class QPlainTextEdit;
 class QComboBox;
 class QCheckBox;
-class QProcess;
 template <typename T> class QList;
 
 class TranscriptionPipeline : public QObject
@@ -15,33 +19,59 @@ public:
         QPlainTextEdit  *console,
         QComboBox       *model,
         QComboBox       *language,
+        QComboBox       *precision,
         QCheckBox       *txtCheckbox,
         QCheckBox       *srtCheckbox,
         QCheckBox       *cpuCheckbox,
         QCheckBox       *openCheckbox,
+        QCheckBox       *draftCheckbox,
         QPlainTextEdit  *arguments,
         QList<QProcess*> *processList,
         QObject *parent = nullptr);
 
-    void start(const QString &inputPath);
+    // Cancelling the token kills the job's processes, removes what it had
+    // half written and emits finished() before cancel() returns.
+    void start(const QString &inputPath, const CancelToken &token = CancelToken());
+
+    // Forgets the console lines kept for draft replacement. Call it before
+    // clearing the console, since their QTextBlock handles go stale.
+    void clearDrafts();
 
 signals:
     void finished();
+    void transcribed(const QString &source, const QString &whisperOutput);
 
 private:
+    void track(QProcess *p);
+    void reap(QProcess *p);
+    void abort();
+    void finish();
+
     /* ordered helper steps */
     void convertToMp3();
+    void decodeWav();
     void checkModel();
+    void selectVariant();
+    void quantizeModel(const QString &quant);
     void runWhisper();
 
+    /* draft-then-refine: small model on the shared WAV while the big one loads */
+    void startDraft();
+    void runDraft(const QString &draftModel);
+    void showDraft(const QString &line);
+    void showRefined(const QString &line);
+    void dropDrafts();
+
     /* UI / state pointers (live widgets) */
     QPlainTextEdit  *console;
     QComboBox       *model;
     QComboBox       *language;
+    QComboBox       *precision;
     QCheckBox       *txtCheckbox;
     QCheckBox       *srtCheckbox;
     QCheckBox       *cpuCheckbox;
     QCheckBox       *openCheckbox;
+    QCheckBox       *draftCheckbox;
     QPlainTextEdit  *arguments;
     QList<QProcess*> *processList;
 
@@ -49,4 +79,26 @@ private:
     QString srcFile;      // original
     QString mp3File;      // converted
     QString outputTxt;    // mp3File + ".txt"
+    QString modelPath;    // full or quantized variant picked for this job
+    QString whisperLog;   // whisper-cli output, parsed for timings
+
+    /* cancellation */
+    CancelToken token;
+    int job = 0;                        // stale cancel callbacks compare against this
+    bool running = false;
+    QList<QPointer<QProcess>> jobProcs; // everything this job started
+    QStringList partials;               // files to remove if the job is cancelled
+
+    /* draft mode */
+    struct DraftLine {
+        qint64 startMs;
+        qint64 endMs;
+        QTextBlock block;   // console line to replace
+    };
+    bool drafting = false;
+    QString wavFile;      // 16 kHz mono PCM, decoded once for both passes
+    QProcess *draftProc = nullptr;
+    QString draftBuf;     // partial lines between reads
+    QString refineBuf;
+    QVector<DraftLine> drafts;
 };
@@ -38,6 +38,9 @@ void WindowHelper::handleBlur()
     ui->language->setAttribute(Qt::WA_TranslucentBackground);
     ui->language->setStyleSheet(widgetBackground);
 
+    ui->precision->setAttribute(Qt::WA_TranslucentBackground);
+    ui->precision->setStyleSheet(widgetBackground);
+
     ui->arguments->setAttribute(Qt::WA_TranslucentBackground);
     ui->arguments->setStyleSheet(widgetBackground);
 
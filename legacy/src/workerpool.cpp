@@ -0,0 +1,436 @@
+#include "workerpool.h"
+#include "workerprotocol.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QProcess>
+#include <QTcpSocket>
+
+static constexpr int kMaxBackoffMs   = 30000;
+static constexpr int kNoWorkerWaitMs = 60000;   // waiting with nobody connected → run it locally
+
+WorkerPool::WorkerPool(QObject *parent) : QObject(parent)
+{
+    clock.start();
+    watchdog.setInterval(1000);
+    connect(&watchdog, &QTimer::timeout, this, &WorkerPool::tick);
+}
+
+WorkerPool::~WorkerPool()
+{
+    if (prep) {
+        prep->disconnect(this);
+        prep->kill();
+        prep->waitForFinished(500);   // before `scratch` removes its output
+    }
+
+    // sockets would otherwise report "disconnected" into deleted Remotes
+    for (Remote *r : remotes)
+        if (r->sock) {
+            r->sock->disconnect(this);
+            delete r->sock;
+        }
+    qDeleteAll(remotes);
+}
+
+void WorkerPool::setWorkers(const QStringList &hostPorts)
+{
+    // detach every old worker before dispatching anything, so a job isn't
+    // handed to one that is removed a moment later; being removed isn't the
+    // job's fault, so it goes back without using up an attempt
+    for (Remote *r : remotes) {
+        if (r->jobId != -1 && !r->cancelling)
+            requeue(running.take(r->jobId));
+        if (r->sock) {
+            r->sock->disconnect(this);
+            r->sock->abort();
+            r->sock->deleteLater();   // the worker kills its job on disconnect
+        }
+    }
+    qDeleteAll(remotes);
+    remotes.clear();
+
+    for (const QString &hp : hostPorts) {
+        const int colon = hp.lastIndexOf(':');
+        auto *r = new Remote;
+        r->host = colon > 0 ? hp.left(colon).trimmed() : hp.trimmed();
+        r->port = colon > 0 ? quint16(hp.mid(colon + 1).toUInt()) : WorkerProtocol::defaultPort;
+        if (r->host.isEmpty()) {
+            delete r;
+            continue;
+        }
+        remotes << r;
+        connectRemote(r);
+    }
+    emit capacityChanged(capacity());
+
+    // local only now: nobody will ever take these, give them back to the queue
+    if (remotes.isEmpty() && !pending.isEmpty()) {
+        QStringList files;
+        for (const Job &job : pending) {
+            files << job.file;
+            release(job);
+        }
+        pending.clear();
+        emit jobsReturned(files);
+    }
+
+    if (remotes.isEmpty() && pending.isEmpty())
+        watchdog.stop();
+    else
+        watchdog.start();
+}
+
+QStringList WorkerPool::workers() const
+{
+    QStringList out;
+    for (const Remote *r : remotes)
+        out << QString("%1:%2").arg(r->host).arg(r->port);
+    return out;
+}
+
+int WorkerPool::capacity() const
+{
+    int n = 0;
+    for (const Remote *r : remotes)
+        n += r->ready ? 1 : 0;
+    return n;
+}
+
+/* ---------- connections ---------- */
+void WorkerPool::connectRemote(Remote *r)
+{
+    delete r->sock;
+    r->sock = new QTcpSocket(this);
+    r->buf.clear();
+    r->ready = false;
+
+    connect(r->sock, &QTcpSocket::readyRead, this, [this, r]{
+        r->buf += r->sock->readAll();
+        r->lastSeen.restart();
+        QVariantMap msg;
+        bool tooBig = false;
+        while (r->sock && WorkerProtocol::takeFrame(r->buf, msg, &tooBig))
+            onFrame(r, msg);
+        if (tooBig && r->sock)
+            lose(r, "oversized frame");
+    });
+    connect(r->sock, &QTcpSocket::disconnected, this, [this, r]{ lose(r, "disconnected"); });
+    connect(r->sock, &QAbstractSocket::errorOccurred, this, [this, r]{
+        lose(r, r->sock ? r->sock->errorString() : QString());
+    });
+
+    r->lastSeen.start();
+    r->sock->connectToHost(r->host, r->port);
+}
+
+void WorkerPool::lose(Remote *r, const QString &why)
+{
+    const bool wasReady = r->ready;
+    r->ready = false;
+
+    // put its job back at the front so it doesn't lose its place
+    if (r->cancelling) {
+        r->cancelling = false;
+        r->jobId = -1;
+    } else if (r->jobId != -1) {
+        Job job = running.take(r->jobId);
+        r->jobId = -1;
+        if (++job.attempts < maxAttempts) {
+            emit message(QString("Worker %1 lost (%2), retrying %3")
+                             .arg(r->host, why, QFileInfo(job.file).fileName()));
+            requeue(job);
+        } else {
+            release(job);
+            emit message("Giving up on " + QFileInfo(job.file).fileName());
+            emit jobFinished(job.file, false, QString());
+        }
+    }
+
+    if (r->sock) {
+        QTcpSocket *s = r->sock;
+        r->sock = nullptr;
+        s->disconnect(this);
+        s->abort();
+        s->deleteLater();
+    }
+
+    r->retryAt = clock.elapsed() + r->backoffMs;
+    r->backoffMs = qMin(r->backoffMs * 2, kMaxBackoffMs);
+
+    if (wasReady)
+        emit capacityChanged(capacity());
+    dispatch();
+}
+
+/* ---------- protocol ---------- */
+void WorkerPool::onFrame(Remote *r, const QVariantMap &msg)
+{
+    const QString type = msg.value("type").toString();
+
+    if (type == "hello") {
+        r->ready = true;
+        r->backoffMs = 1000;
+        emit message(QString("Worker %1:%2 ready").arg(r->host).arg(r->port));
+        emit capacityChanged(capacity());
+        dispatch();
+    } else if (type == "result") {
+        const int id = msg.value("id").toInt();
+        if (id != r->jobId)
+            return;   // stale answer for a job we already moved
+        if (r->cancelling) {
+            // the worker has stopped and cleaned up; it can take new work
+            r->cancelling = false;
+            r->jobId = -1;
+            dispatch();
+            return;
+        }
+        Job job = running.take(id);
+        r->jobId = -1;
+
+        if (msg.value("ok").toBool()) {
+            // throughput in source bytes per second, smoothed
+            const double secs = qMax<qint64>(1, r->jobTimer.elapsed()) / 1000.0;
+            const double rate = r->jobBytes / secs;
+            r->bytesPerSec = r->bytesPerSec == 0.0 ? rate : 0.7 * r->bytesPerSec + 0.3 * rate;
+
+            writeOutputs(job, msg);
+            release(job);
+            emit message(QString("%1 done on %2 (%3 s, %4 KB/s)")
+                             .arg(QFileInfo(job.file).fileName(), r->host)
+                             .arg(secs, 0, 'f', 1).arg(r->bytesPerSec / 1024.0, 0, 'f', 0));
+            emit jobFinished(job.file, true, msg.value("log").toString());
+        } else if (++job.attempts < maxAttempts) {
+            emit message(QString("%1 failed on %2, retrying").arg(QFileInfo(job.file).fileName(), r->host));
+            requeue(job);
+        } else {
+            release(job);
+            emit message("Giving up on " + QFileInfo(job.file).fileName());
+            emit jobFinished(job.file, false, msg.value("log").toString());
+        }
+        dispatch();
+    }
+    // "ping" only refreshes lastSeen
+}
+
+void WorkerPool::submit(const QString &file, const QVariantMap &params, const CancelToken &token)
+{
+    Job job;
+    job.id = nextId++;
+    job.file = file;
+    job.params = params;
+    job.queuedAt = clock.elapsed();
+    job.token = token;
+    pending.enqueue(job);
+    if (!watchdog.isActive())
+        watchdog.start();   // tick() fails it if no worker ever shows up
+    token.onCancel([this, id = job.id]{ cancelJob(id); });
+    if (!token.isCancelled())
+        dispatch();
+}
+
+void WorkerPool::cancelJob(int id)
+{
+    for (int i = 0; i < pending.size(); ++i) {
+        if (pending.at(i).id == id) {
+            const Job job = pending.takeAt(i);
+            if (prep && prepId == id)
+                prep->kill();   // its finished handler removes the partial output
+            release(job);
+            emit jobCancelled(job.file);
+            return;
+        }
+    }
+
+    if (!running.contains(id))
+        return;   // already finished
+    const Job job = running.take(id);
+    release(job);
+    for (Remote *r : remotes) {
+        if (r->jobId == id && r->sock) {
+            r->cancelling = true;
+            r->sock->write(WorkerProtocol::frame({ { "type", "cancel" }, { "id", id } }));
+        }
+    }
+    emit message("Cancelled " + QFileInfo(job.file).fileName());
+    emit jobCancelled(job.file);
+}
+
+static bool isReady(const QVariantMap &params, const QString &audio)
+{
+    return params.value("shared").toBool() || !audio.isEmpty();
+}
+
+void WorkerPool::dispatch()
+{
+    for (;;) {
+        // unmeasured workers first so everyone gets a rate, then the fastest
+        Remote *best = nullptr;
+        for (Remote *r : remotes) {
+            if (!r->ready || r->jobId != -1)
+                continue;
+            if (!best
+                || (r->bytesPerSec == 0.0 && best->bytesPerSec != 0.0)
+                || (best->bytesPerSec != 0.0 && r->bytesPerSec > best->bytesPerSec))
+                best = r;
+        }
+
+        // oldest job whose audio is ready; the rest are still being extracted
+        int next = -1;
+        for (int i = 0; i < pending.size() && next < 0; ++i)
+            if (isReady(pending.at(i).params, pending.at(i).audio))
+                next = i;
+        if (!best || next < 0)
+            break;
+
+        Job job = pending.takeAt(next);
+        QVariantMap msg = job.params;
+        msg["type"] = "job";
+        msg["id"] = job.id;
+
+        if (job.params.value("shared").toBool()) {
+            msg["name"] = QFileInfo(job.file).fileName();
+            msg["path"] = job.file;
+        } else {
+            QFile f(job.audio);
+            if (!f.open(QIODevice::ReadOnly)) {
+                release(job);
+                emit message("Cannot read " + job.file);
+                emit jobFinished(job.file, false, QString());
+                continue;
+            }
+            msg["name"] = QFileInfo(job.file).completeBaseName() + ".ogg";
+            msg["data"] = f.readAll();
+        }
+
+        best->jobId = job.id;
+        best->jobBytes = QFileInfo(job.audio.isEmpty() ? job.file : job.audio).size();
+        best->jobTimer.start();
+        best->lastSeen.restart();
+        running.insert(job.id, job);
+        best->sock->write(WorkerProtocol::frame(msg));
+    }
+    prepareNext();
+}
+
+// Workers get the audio track as 16 kHz mono Opus rather than the source:
+// an hour of video becomes ~14 MB, so a frame never holds a whole container
+// and the coordinator never reads one into memory. One extraction runs at a
+// time, staying about one job ahead of the idle workers.
+void WorkerPool::prepareNext()
+{
+    if (prep)
+        return;
+
+    int ready = 0;
+    for (const Job &job : pending)
+        ready += job.audio.isEmpty() ? 0 : 1;
+    if (ready >= qMax(1, capacity()))
+        return;
+
+    for (const Job &job : pending) {
+        if (isReady(job.params, job.audio))
+            continue;
+
+        const QString out = scratch.filePath(QString::number(job.id) + ".ogg");
+        prep = new QProcess(this);
+        prepId = job.id;
+        prep->setProcessChannelMode(QProcess::MergedChannels);
+
+        connect(prep, QOverload<int,QProcess::ExitStatus>::of(&QProcess::finished),
+                this, [this, out](int code, QProcess::ExitStatus st){
+                    const int id = prepId;
+                    prep->deleteLater();
+                    prep = nullptr;
+                    prepId = -1;
+
+                    const bool ok = st == QProcess::NormalExit && code == 0 && QFileInfo(out).size() > 0;
+                    bool found = false;
+                    for (int i = 0; i < pending.size(); ++i) {
+                        if (pending.at(i).id != id)
+                            continue;
+                        found = true;
+                        if (ok) {
+                            pending[i].audio = out;
+                        } else {
+                            const Job job = pending.takeAt(i);
+                            emit message("Cannot extract audio from " + QFileInfo(job.file).fileName());
+                            emit jobFinished(job.file, false, QString());
+                        }
+                        break;
+                    }
+                    if (!ok || !found)
+                        QFile::remove(out);   // failed, or the job was cancelled meanwhile
+                    dispatch();
+                });
+        prep->start("ffmpeg", { "-y", "-v", "error", "-i", job.file, "-vn", "-ac", "1", "-ar", "16000",
+                                "-c:a", "libopus", "-b:a", "32k", out });
+        return;
+    }
+}
+
+// back to the front of the line; the no-worker wait restarts from now, so
+// a worker restart mid-job doesn't count against it
+void WorkerPool::requeue(Job job)
+{
+    job.queuedAt = clock.elapsed();
+    pending.prepend(job);
+}
+
+void WorkerPool::release(const Job &job)
+{
+    if (!job.audio.isEmpty())
+        QFile::remove(job.audio);
+}
+
+/* ---------- watchdog ---------- */
+void WorkerPool::tick()
+{
+    const qint64 now = clock.elapsed();
+
+    for (Remote *r : remotes) {
+        // covers a hung box, a half-open connection and a connect that never completes
+        if (r->sock && r->lastSeen.elapsed() > heartbeatTimeoutMs)
+            lose(r, "no heartbeat");
+        else if (!r->sock && now >= r->retryAt)
+            connectRemote(r);
+    }
+
+    // nobody to run them on for a while → hand them back for the local
+    // pipeline rather than hang the queue or fail them
+    if (capacity() == 0) {
+        QStringList files;
+        for (int i = 0; i < pending.size(); ) {
+            if (now - pending.at(i).queuedAt <= kNoWorkerWaitMs) {
+                ++i;
+                continue;
+            }
+            const Job job = pending.takeAt(i);
+            release(job);
+            files << job.file;
+        }
+        if (!files.isEmpty()) {
+            emit message(QString("No workers, running %1 file(s) locally").arg(files.size()));
+            emit jobsReturned(files);
+        }
+    }
+
+    if (remotes.isEmpty() && pending.isEmpty())
+        watchdog.stop();
+}
+
+void WorkerPool::writeOutputs(const Job &job, const QVariantMap &result)
+{
+    // same names the local pipeline uses: <name>.mp3.txt / .mp3.srt
+    const QFileInfo fi(job.file);
+    const QString base = fi.absolutePath() + "/" + fi.completeBaseName() + ".mp3";
+
+    auto save = [](const QString &path, const QByteArray &data) {
+        QFile f(path);
+        if (!data.isEmpty() && f.open(QIODevice::WriteOnly))
+            f.write(data);
+    };
+    if (job.params.value("txt").toBool())
+        save(base + ".txt", result.value("txt").toByteArray());
+    if (job.params.value("srt").toBool())
+        save(base + ".srt", result.value("srt").toByteArray());
+}
@@ -0,0 +1,99 @@
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#pragma once
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QQueue>
+#include <QTemporaryDir>
+#include <QTimer>
+#include <QVariantMap>
+#include "canceltoken.h"
+
+class QProcess;
+class QTcpSocket;
+
+// Coordinator side of the distributed mode: keeps a connection to each
+// `--worker` process, hands it one job at a time and writes the returned
+// .txt/.srt next to the source. Lost or failed jobs are retried on another
+// worker. When several are idle, the job goes to the fastest one measured.
+// Workers receive only the extracted audio, or the path of a file on a share.
+class WorkerPool : public QObject
+{
+    Q_OBJECT
+public:
+    explicit WorkerPool(QObject *parent = nullptr);
+    ~WorkerPool();
+
+    void setWorkers(const QStringList &hostPorts);   // "host:port"
+    QStringList workers() const;
+    int capacity() const;                            // connected workers
+
+    // params: model, language, precision, args, cpu, txt, srt, shared
+    // Cancelling the token drops a queued job or tells its worker to stop;
+    // jobCancelled() then replaces jobFinished() for that file.
+    void submit(const QString &file, const QVariantMap &params,
+                const CancelToken &token = CancelToken());
+
+    int maxAttempts = 3;
+    int heartbeatTimeoutMs = 20000;
+
+signals:
+    void capacityChanged(int workers);
+    void jobFinished(const QString &file, bool ok, const QString &whisperOutput);
+    void jobCancelled(const QString &file);
+    void jobsReturned(const QStringList &files);   // no worker to run them; back to the caller's queue
+    void message(const QString &line);
+
+private:
+    struct Job {
+        int id = 0;
+        QString file;
+        QVariantMap params;
+        int attempts = 0;
+        qint64 queuedAt = 0;
+        CancelToken token;   // the queue only holds children weakly; this keeps it alive
+        QString audio;       // extracted Opus track in `scratch`, "" until ready
+    };
+
+    struct Remote {
+        QString host;
+        quint16 port = 0;
+        QTcpSocket *sock = nullptr;
+        QByteArray buf;
+        bool ready = false;          // hello received
+        int jobId = -1;              // -1 = idle
+        bool cancelling = false;     // job cancelled, slot held until the worker confirms
+        qint64 jobBytes = 0;
+        QElapsedTimer jobTimer;
+        QElapsedTimer lastSeen;
+        double bytesPerSec = 0.0;    // EWMA, 0 = not measured yet
+        qint64 retryAt = 0;          // ms on `clock` for the next reconnect
+        int backoffMs = 1000;
+    };
+
+    void connectRemote(Remote *r);
+    void onFrame(Remote *r, const QVariantMap &msg);
+    void lose(Remote *r, const QString &why);
+    void dispatch();
+    void cancelJob(int id);
+    void prepareNext();
+    void requeue(Job job);
+    void release(const Job &job);
+    void tick();
+    void writeOutputs(const Job &job, const QVariantMap &result);
+
+    QList<Remote*> remotes;
+    QQueue<Job> pending;
+    QHash<int, Job> running;
+    int nextId = 1;
+    QTimer watchdog;
+    QElapsedTimer clock;
+    QTemporaryDir scratch;
+    QProcess *prep = nullptr;        // ffmpeg extracting the audio for prepId
+    int prepId = -1;
+};
+
+#endif // WORKERPOOL_H
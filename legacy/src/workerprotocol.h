@@ -0,0 +1,63 @@
+#ifndef WORKERPROTOCOL_H
+#define WORKERPROTOCOL_H
+
+#pragma once
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QVariantMap>
+#include <QtEndian>
+
+// Coordinator ↔ worker wire format: a 4-byte big-endian length followed by
+// a QDataStream-serialised QVariantMap. Every map has a "type":
+//   worker → hello  { slots }
+//   coord  → job    { id, name, path | data, model, language, args, cpu }
+//   coord  → cancel { id }
+//   worker → result { id, ok, log, txt, srt }
+//   worker → ping   {}                      every few seconds, as a heartbeat
+// `data` is the audio track re-encoded to 16 kHz mono Opus, never the
+// original container, which keeps a job frame far below maxFrameBytes.
+namespace WorkerProtocol
+{
+constexpr quint16 defaultPort = 47800;
+constexpr int heartbeatMs     = 5000;
+constexpr quint32 maxFrameBytes = 256u * 1024 * 1024;   // ~18 h of 32 kbps audio
+
+inline QByteArray frame(const QVariantMap &msg)
+{
+    QByteArray body;
+    QDataStream ds(&body, QIODevice::WriteOnly);
+    ds.setVersion(QDataStream::Qt_5_12);
+    ds << msg;
+
+    QByteArray out(4, Qt::Uninitialized);
+    qToBigEndian(quint32(body.size()), out.data());
+    return out + body;
+}
+
+// Pops one complete frame off the front of buf; false if it isn't all there
+// yet. A length over maxFrameBytes sets *tooBig: drop the connection rather
+// than buffer it.
+inline bool takeFrame(QByteArray &buf, QVariantMap &msg, bool *tooBig = nullptr)
+{
+    if (buf.size() < 4)
+        return false;
+    const quint32 len = qFromBigEndian<quint32>(buf.constData());
+    if (len > maxFrameBytes) {
+        if (tooBig)
+            *tooBig = true;
+        return false;
+    }
+    if (quint32(buf.size()) - 4 < len)
+        return false;
+
+    QDataStream ds(buf.mid(4, int(len)));
+    ds.setVersion(QDataStream::Qt_5_12);
+    msg.clear();
+    ds >> msg;
+    buf.remove(0, int(len) + 4);
+    return true;
+}
+}
+
+#endif // WORKERPROTOCOL_H
@@ -0,0 +1,249 @@
+#include "workerserver.h"
+#include "workerprotocol.h"
+#include "modelprofile.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QProcess>
+#include <QRegularExpression>
+#include <QTcpSocket>
+#include <QTemporaryDir>
+#include <QThread>
+
+// whisper-cli options a coordinator may pass through, and whether each takes
+// a value. Everything else is dropped: -of, -m, -f and the output options
+// name files, and a worker must not write wherever a peer asks it to.
+static QStringList safeArgs(const QString &args, QStringList *dropped)
+{
+    static const QHash<QString, bool> allowed{
+        { "-t", true },    { "--threads", true },       { "-p", true },    { "--processors", true },
+        { "-ot", true },   { "--offset-t", true },      { "-d", true },    { "--duration", true },
+        { "-mc", true },   { "--max-context", true },   { "-ml", true },   { "--max-len", true },
+        { "-bo", true },   { "--best-of", true },       { "-bs", true },   { "--beam-size", true },
+        { "-wt", true },   { "--word-thold", true },    { "-et", true },   { "--entropy-thold", true },
+        { "-lpt", true },  { "--logprob-thold", true }, { "-tp", true },   { "--temperature", true },
+        { "-tpi", true },  { "--temperature-inc", true }, { "--prompt", true },
+        { "-sow", false }, { "--split-on-word", false }, { "-tr", false }, { "--translate", false },
+        { "-nf", false },  { "--no-fallback", false },  { "-sns", false }, { "--suppress-nst", false },
+        { "-fa", false },  { "--flash-attn", false },
+    };
+
+    const QStringList in = QProcess::splitCommand(args);
+    QStringList out;
+    for (int i = 0; i < in.size(); ++i) {
+        const auto it = allowed.constFind(in[i]);
+        if (it == allowed.cend()) {
+            *dropped << in[i];
+        } else if (!it.value()) {
+            out << in[i];
+        } else if (i + 1 < in.size()) {
+            out << in[i] << in[i + 1];
+            ++i;
+        }
+    }
+    return out;
+}
+
+WorkerServer::WorkerServer(QObject *parent) : QObject(parent)
+{
+    connect(&server, &QTcpServer::newConnection, this, [this]{
+        while (QTcpSocket *sock = server.nextPendingConnection()) {
+            emit log("Coordinator connected: " + sock->peerAddress().toString());
+            buffers.insert(sock, QByteArray());
+            connect(sock, &QTcpSocket::readyRead, this, [this, sock]{ onReadable(sock); });
+            connect(sock, &QTcpSocket::disconnected, this, [this, sock]{
+                buffers.remove(sock);
+                if (sock == jobSock && current)
+                    current->kill();   // nobody left to take the result
+                sock->deleteLater();
+            });
+            reply(sock, { { "type", "hello" }, { "slots", 1 } });
+        }
+    });
+
+    // lets the coordinator tell a long job from a dead worker
+    heartbeat.setInterval(WorkerProtocol::heartbeatMs);
+    connect(&heartbeat, &QTimer::timeout, this, [this]{
+        for (QTcpSocket *sock : buffers.keys())
+            reply(sock, { { "type", "ping" } });
+    });
+    heartbeat.start();
+}
+
+bool WorkerServer::listen(quint16 port, const QHostAddress &address)
+{
+    if (!server.listen(address, port)) {
+        emit log("Cannot listen: " + server.errorString());
+        return false;
+    }
+    emit log(QString("Worker listening on %1:%2").arg(server.serverAddress().toString())
+                 .arg(server.serverPort()));
+    return true;
+}
+
+void WorkerServer::reply(QTcpSocket *sock, const QVariantMap &msg)
+{
+    if (sock && sock->state() == QAbstractSocket::ConnectedState)
+        sock->write(WorkerProtocol::frame(msg));
+}
+
+void WorkerServer::onReadable(QTcpSocket *sock)
+{
+    QByteArray &buf = buffers[sock];
+    buf += sock->readAll();
+
+    QVariantMap msg;
+    bool tooBig = false;
+    while (WorkerProtocol::takeFrame(buf, msg, &tooBig)) {
+        const QString type = msg.value("type").toString();
+        if (type == "cancel") {
+            if (busy && sock == jobSock && msg.value("id") == jobId) {
+                emit log("Job " + jobId.toString() + " cancelled");
+                cancelRequested = true;
+                if (current)
+                    current->kill();   // its finished handler replies and cleans up
+            }
+            continue;
+        }
+        if (type != "job")
+            continue;
+        if (busy) {
+            reply(sock, { { "type", "result" }, { "id", msg.value("id") },
+                          { "ok", false }, { "log", "worker busy" } });
+            continue;
+        }
+        runJob(sock, msg);
+    }
+
+    if (tooBig) {
+        emit log("Oversized frame from " + sock->peerAddress().toString() + ", disconnecting");
+        sock->abort();
+    }
+}
+
+void WorkerServer::runStep(const QString &exe, const QStringList &args,
+                           std::function<void(bool ok)> next)
+{
+    if (cancelRequested)
+        return next(false);
+
+    auto *p = new QProcess(this);
+    current = p;
+    p->setProcessChannelMode(QProcess::MergedChannels);
+
+    connect(p, &QProcess::readyRead,
+            this, [=]{ jobLog += QString::fromLocal8Bit(p->readAll()); });
+
+    connect(p, QOverload<int,QProcess::ExitStatus>::of(&QProcess::finished),
+            this, [=](int code, QProcess::ExitStatus st){
+                current = nullptr;
+                p->deleteLater();
+                next(st==QProcess::NormalExit && code==0);
+            });
+    p->start(exe, args);
+}
+
+void WorkerServer::runJob(QTcpSocket *sock, const QVariantMap &job)
+{
+    // both end up in file names and on the whisper-cli command line
+    static const QRegularExpression languageCode("^(auto|[a-z]{2,3})$");
+    const QString modelName = job.value("model").toString();
+    const QString language = job.value("language").toString();
+    if (!ModelProfile::isKnownModel(modelName) || !languageCode.match(language).hasMatch()) {
+        emit log("Rejected job " + job.value("id").toString() + ": unknown model or language");
+        reply(sock, { { "type", "result" }, { "id", job.value("id") },
+                      { "ok", false }, { "log", "rejected: unknown model or language" } });
+        return;
+    }
+
+    busy = true;
+    jobSock = sock;
+    jobId = job.value("id");
+    cancelRequested = false;
+    jobLog.clear();
+    jobDir = new QTemporaryDir;
+
+    const QVariant id = job.value("id");
+    const QString name = QFileInfo(job.value("name").toString()).fileName();
+    emit log("Job " + id.toString() + ": " + name);
+
+    // a UNC share is read in place; local paths are never taken from a peer,
+    // otherwise the audio came in the frame
+    QString input = job.value("path").toString();
+    if (!QDir::fromNativeSeparators(input).startsWith("//") || !QFileInfo::exists(input)) {
+        input = jobDir->filePath(name.isEmpty() ? "input" : name);
+        QFile f(input);
+        if (f.open(QIODevice::WriteOnly))
+            f.write(job.value("data").toByteArray());
+    }
+
+    const QString quant = ModelProfile::choose(modelName,
+                                               ModelProfile::Preference(job.value("precision", 1).toInt()),
+                                               job.value("cpu").toBool());
+    QString modelPath = ModelProfile::fileFor(modelName, quant);
+    if (!QFile::exists(modelPath))
+        modelPath = ModelProfile::fileFor(modelName);   // quantizing is the coordinator's job
+
+    const QString wav = jobDir->filePath("audio.wav");
+    const QString outBase = jobDir->filePath("out");
+    const QString exeDir = QCoreApplication::applicationDirPath();
+
+    auto finish = [=](bool ok) {
+        auto readAll = [](const QString &path) {
+            QFile f(path);
+            return f.open(QIODevice::ReadOnly) ? f.readAll() : QByteArray();
+        };
+        reply(jobSock, { { "type", "result" }, { "id", id }, { "ok", ok }, { "log", jobLog },
+                         { "txt", readAll(outBase + ".txt") }, { "srt", readAll(outBase + ".srt") } });
+        emit log("Job " + id.toString() + (ok ? " done" : " failed"));
+
+        delete jobDir;
+        jobDir = nullptr;
+        jobSock = nullptr;
+        jobId.clear();
+        cancelRequested = false;
+        busy = false;
+    };
+
+    auto whisper = [=](bool ok) {
+        if (!ok)
+            return finish(false);
+        QStringList cmd{ "-m", modelPath, "-f", wav, "-of", outBase, "-otxt", "-osrt",
+                         "-t", QString::number(QThread::idealThreadCount()),
+                         "-l", language };
+        if (job.value("cpu").toBool())
+            cmd << "--no-gpu";
+        QStringList dropped;
+        cmd += safeArgs(job.value("args").toString(), &dropped);
+        if (!dropped.isEmpty())
+            jobLog += "Ignored arguments: " + dropped.join(' ') + "\n";
+        runStep(exeDir + "/whisper-cli.exe", cmd, finish);
+    };
+
+    auto decode = [=](bool ok) {
+        if (!ok)
+            return finish(false);
+        runStep("ffmpeg", { "-y", "-i", input, "-ar", "16000", "-ac", "1", "-c:a", "pcm_s16le", wav },
+                whisper);
+    };
+
+    if (QFile::exists(modelPath)) {
+        decode(true);
+    } else {
+        // private temp name: workers sharing models/ may fetch the same file,
+        // and a cut-off download must never sit under the real name
+        QDir().mkpath(ModelProfile::modelsDir());
+        const QString part = QString("%1.%2.part").arg(modelPath).arg(QCoreApplication::applicationPid());
+        runStep("curl", { "-L", "https://huggingface.co/ggerganov/whisper.cpp/resolve/main/"
+                                + QFileInfo(modelPath).fileName(), "-o", part },
+                [=](bool ok) {
+                    ok = ok && QFileInfo(part).size() > 1'000'000;
+                    // losing the rename to another worker is fine, its copy is complete
+                    if (ok && !QFile::rename(part, modelPath))
+                        ok = QFile::exists(modelPath);
+                    QFile::remove(part);
+                    decode(ok);
+                });
+    }
+}
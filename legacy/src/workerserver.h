@@ -0,0 +1,55 @@
+#ifndef WORKERSERVER_H
+#define WORKERSERVER_H
+
+#pragma once
+
+#include <QObject>
+#include <QHash>
+#include <QPointer>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QVariantMap>
+#include <functional>
+
+class QProcess;
+class QTemporaryDir;
+
+// Headless `--worker [port] [--bind addr]` side: takes one job at a time
+// from a coordinator, runs ffmpeg + whisper-cli locally and sends the
+// outputs back. There is no authentication: it listens on localhost
+// unless --bind names an interface, and that should be a trusted one.
+// Peers can only pick known models and a whitelist of options.
+class WorkerServer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit WorkerServer(QObject *parent = nullptr);
+
+    bool listen(quint16 port, const QHostAddress &address = QHostAddress::LocalHost);
+
+signals:
+    void log(const QString &line);
+
+private:
+    void onReadable(QTcpSocket *sock);
+    void runJob(QTcpSocket *sock, const QVariantMap &job);
+    void runStep(const QString &exe, const QStringList &args,
+                 std::function<void(bool ok)> next);
+    void reply(QTcpSocket *sock, const QVariantMap &msg);
+
+    QTcpServer server;
+    QTimer heartbeat;
+    QHash<QTcpSocket*, QByteArray> buffers;   // partial frames per connection
+
+    /* current job */
+    bool busy = false;
+    QVariant jobId;
+    bool cancelRequested = false;   // coordinator sent "cancel"; skip the remaining steps
+    QPointer<QTcpSocket> jobSock;
+    QProcess *current = nullptr;
+    QString jobLog;
+    QTemporaryDir *jobDir = nullptr;
+};
+
+#endif // WORKERSERVER_H